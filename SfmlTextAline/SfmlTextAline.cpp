@@ -42,14 +42,140 @@
 #include <algorithm>
 #include <functional>
 #include <cmath>
-
-#define SET_AND_UPDATE_MEMBER_IF_DIFFERENT_PTR(x) do { if ((m_##x) != &##x) { ((m_##x) = &##x); m_isUpdateRequired = true; } } while(0)
-#define SET_AND_UPDATE_MEMBER_IF_DIFFERENT(x) do { if ((m_##x) != x) { ((m_##x) = x); m_isUpdateRequired = true; } } while(0)
+#include <limits>
+#include <iterator>
+#include <cstring>
+#include <optional>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // _WIN32
+
+// SFMLTEXTALINE_PROFILE_ZONE(name) can be defined (project-wide) to forward zones to an external profiler (e.g. ZoneScopedN(name) for Tracy)
+#ifndef SFMLTEXTALINE_PROFILE_ZONE
+#define SFMLTEXTALINE_PROFILE_ZONE(name)
+#endif // SFMLTEXTALINE_PROFILE_ZONE
+
+#include <SFML/System/Clock.hpp>
+
+#ifdef SFMLTEXTALINE_ENABLE_STATISTICS
+#define STATISTICS_ONLY(x) x
+#define FLAG_UPDATE_REQUIRED() do { m_isUpdateRequired = true; m_layoutCursor.isInProgress = false; m_statistics.lastInvalidation = __func__; } while(0)
+#else
+#define STATISTICS_ONLY(x)
+#define FLAG_UPDATE_REQUIRED() do { m_isUpdateRequired = true; m_layoutCursor.isInProgress = false; } while(0)
+#endif // SFMLTEXTALINE_ENABLE_STATISTICS
+
+#define SET_AND_UPDATE_MEMBER_IF_DIFFERENT_PTR(x) do { if ((m_##x) != &x) { ((m_##x) = &x); FLAG_UPDATE_REQUIRED(); } } while(0)
+#define SET_AND_UPDATE_MEMBER_IF_DIFFERENT(x) do { if ((m_##x) != x) { ((m_##x) = x); FLAG_UPDATE_REQUIRED(); } } while(0)
 
 namespace
 {
 
 constexpr float defaultItalicShear{ 0.20944f }; // matches SFML's value: 12 degrees as radians
+constexpr std::size_t allCharacters{ std::numeric_limits<std::size_t>::max() };
+constexpr std::size_t allLines{ std::numeric_limits<std::size_t>::max() };
+constexpr std::size_t defaultSourceNumberOfLines{ 1000u }; // loading a large file does not decode all of it unless requested
+constexpr std::size_t defaultShapingCacheCapacity{ 64u };
+constexpr std::size_t minimumSharedLayoutSweepSize{ 64u };
+constexpr std::size_t progressiveLayoutTimeCheckInterval{ 64u };
+constexpr std::uint32_t monospaceTestCharacters[]{ 'i', 'l', '.', 'm', 'W', '0' };
+constexpr float cacheTransformEpsilon{ 0.0001f };
+constexpr unsigned int atlasGlyphPadding{ 1u }; // matches the transparent border around glyphs in font textures (needed for smooth filtering)
+constexpr unsigned int minimumAtlasWidth{ 512u };
+constexpr unsigned int minimumAtlasHeight{ 128u };
+
+// cache is rendered with premultiplied alpha so that it can be blended as if its glyphs were drawn directly
+const sf::BlendMode cacheRenderBlendMode{ sf::BlendMode::SrcAlpha, sf::BlendMode::OneMinusSrcAlpha, sf::BlendMode::Add, sf::BlendMode::One, sf::BlendMode::OneMinusSrcAlpha, sf::BlendMode::Add };
+const sf::BlendMode cacheDrawBlendMode{ sf::BlendMode::One, sf::BlendMode::OneMinusSrcAlpha };
+
+inline std::uint64_t getGlyphKey(const std::uint32_t character, const bool bold)
+{
+	return (static_cast<std::uint64_t>(character) << 1u) | (bold ? 1u : 0u);
+}
+
+inline std::uint64_t getAtlasGlyphKey(const sf::IntRect& textureRect)
+{
+	return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(textureRect.left)) << 32u) | static_cast<std::uint32_t>(textureRect.top);
+}
+
+inline unsigned int getPowerOfTwo(const unsigned int minimum)
+{
+	unsigned int powerOfTwo{ 1u };
+	while (powerOfTwo < minimum)
+		powerOfTwo <<= 1u;
+	return powerOfTwo;
+}
+
+inline std::uint64_t getKerningKey(const std::uint32_t first, const std::uint32_t second)
+{
+	return (static_cast<std::uint64_t>(first) << 32u) | second;
+}
+
+inline void combineHash(std::size_t& seed, const std::size_t value)
+{
+	seed ^= value + 0x9e3779b9u + (seed << 6u) + (seed >> 2u);
+}
+
+inline std::size_t getColorHash(const sf::Color color)
+{
+	return (static_cast<std::size_t>(color.r) << 24u) | (static_cast<std::size_t>(color.g) << 16u) | (static_cast<std::size_t>(color.b) << 8u) | color.a;
+}
+
+// order of elements does not affect the hash
+template <class T, class H>
+std::size_t getMapHash(const std::unordered_map<std::size_t, T>& map, H elementHash)
+{
+	std::size_t hash{ map.size() };
+	for (auto& element : map)
+	{
+		std::size_t elementSeed{ element.first };
+		combineHash(elementSeed, elementHash(element.second));
+		hash += elementSeed;
+	}
+	return hash;
+}
+
+#ifdef SFMLTEXTALINE_ENABLE_STATISTICS
+template <class T>
+inline std::size_t getVectorBytes(const std::vector<T>& vector)
+{
+	return vector.capacity() * sizeof(T);
+}
+
+inline std::size_t getStringBytes(const sf::String& string)
+{
+	return string.getSize() * sizeof(std::uint32_t);
+}
+
+// estimate: exact node and bucket overhead depends on the standard library
+template <class T>
+inline std::size_t getMapBytes(const T& map)
+{
+	return (map.size() * (sizeof(typename T::value_type) + sizeof(void*))) + (map.bucket_count() * sizeof(void*));
+}
+
+inline std::size_t getTextureBytes(const sf::Vector2u size)
+{
+	return static_cast<std::size_t>(size.x) * size.y * 4u;
+}
+#endif // SFMLTEXTALINE_ENABLE_STATISTICS
+
+inline bool isWhitespace(const std::uint32_t character)
+{
+	return (character == ' ') || (character == '\n') || (character == '\t');
+}
 
 void setGlyph(std::vector<sf::Vertex>& vertices, std::size_t& quad, const sf::Glyph& glyph, const sf::Vector2f position, const float italicShear)
 {
@@ -83,7 +209,9 @@ void setGlyph(std::vector<sf::Vertex>& vertices, std::size_t& quad, const sf::Gl
 void resetToDefaultValues(SfmlTextAline& sfmlTextAline)
 {
 	sfmlTextAline.setFont();
+	sfmlTextAline.removeFallbackFonts();
 	sfmlTextAline.setString("");
+	sfmlTextAline.setSourceLineRange(0u, defaultSourceNumberOfLines);
 	sfmlTextAline.setCharacterSize(30u);
 	sfmlTextAline.setColor(sf::Color::White);
 	sfmlTextAline.setTabLength(4u);
@@ -94,15 +222,147 @@ void resetToDefaultValues(SfmlTextAline& sfmlTextAline)
 	sfmlTextAline.setLetterSpacingMultiplier(0.f);
 	sfmlTextAline.setLineHeightMultiplier(1.f);
 	sfmlTextAline.setIsRoundingApplied(true);
+	sfmlTextAline.setIsMonospace(false);
+	sfmlTextAline.setIsTableLayout(false);
+	sfmlTextAline.removeColumnAlignments();
+	sfmlTextAline.setShaper();
+	sfmlTextAline.setIsLayoutAsync(false);
+	sfmlTextAline.setIsLayoutShared(false);
+	sfmlTextAline.setIsCached(false);
+	sfmlTextAline.removeLayoutBudget();
 	sfmlTextAline.removeLineAlignments();
 	sfmlTextAline.removeLineOffsets();
 	sfmlTextAline.removeLineColors();
 	sfmlTextAline.removeLineBolds();
 	sfmlTextAline.removeLineItalics();
+	sfmlTextAline.removeVisibleCharacterRange();
+	sfmlTextAline.removeCharacterAlphas();
 }
 
 } // namespace
 
+struct SfmlTextAline::Source
+{
+	const char* data{ nullptr };
+	std::size_t size{ 0u };
+	std::vector<std::size_t> lineStarts; // byte offset of each line
+#ifdef _WIN32
+	HANDLE file{ INVALID_HANDLE_VALUE };
+	HANDLE mapping{ nullptr };
+#endif // _WIN32
+
+	bool map(const std::string& filename)
+	{
+#ifdef _WIN32
+		file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize))
+			return false;
+		size = static_cast<std::size_t>(fileSize.QuadPart);
+		if (size == 0u)
+			return true;
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+			return false;
+		data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		return (data != nullptr);
+#else
+		const int file{ ::open(filename.c_str(), O_RDONLY) };
+		if (file < 0)
+			return false;
+		struct stat fileStatus;
+		bool isMapped{ ::fstat(file, &fileStatus) == 0 };
+		if (isMapped && (fileStatus.st_size > 0))
+		{
+			void* mapped{ ::mmap(nullptr, static_cast<std::size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, file, 0) };
+			isMapped = (mapped != MAP_FAILED);
+			if (isMapped)
+			{
+				data = static_cast<const char*>(mapped);
+				size = static_cast<std::size_t>(fileStatus.st_size);
+			}
+		}
+		::close(file);
+		return isMapped;
+#endif // _WIN32
+	}
+
+	void index()
+	{
+		// skip byte order mark
+		const std::size_t start{ ((size >= 3u) && (std::memcmp(data, "\xEF\xBB\xBF", 3u) == 0)) ? 3u : 0u };
+
+		// single scan for newlines (memchr is vectorised by standard libraries)
+		lineStarts.clear();
+		lineStarts.push_back(start);
+		const char* const end{ data + size };
+		for (const char* newline{ (size > start) ? static_cast<const char*>(std::memchr(data + start, '\n', size - start)) : nullptr }; newline != nullptr; newline = static_cast<const char*>(std::memchr(newline + 1, '\n', static_cast<std::size_t>(end - (newline + 1)))))
+			lineStarts.push_back(static_cast<std::size_t>(newline + 1 - data));
+	}
+
+	sf::String decode(const std::size_t firstLine, const std::size_t numberOfLines) const
+	{
+		sf::String string;
+		const std::size_t endLine{ firstLine + std::min(numberOfLines, lineStarts.size() - std::min(firstLine, lineStarts.size())) };
+		for (std::size_t l{ firstLine }; l < endLine; ++l)
+		{
+			const std::size_t lineStart{ lineStarts[l] };
+			std::size_t lineEnd{ (l + 1u < lineStarts.size()) ? lineStarts[l + 1u] - 1u : size };
+			if ((lineEnd > lineStart) && (data[lineEnd - 1u] == '\r'))
+				--lineEnd;
+			if (l > firstLine)
+				string += '\n';
+			string += sf::String::fromUtf8(data + lineStart, data + lineEnd);
+		}
+		return string;
+	}
+
+	~Source()
+	{
+#ifdef _WIN32
+		if (data != nullptr)
+			UnmapViewOfFile(data);
+		if (mapping != nullptr)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+#else
+		if (data != nullptr)
+			::munmap(const_cast<char*>(data), size);
+#endif // _WIN32
+	}
+};
+
+struct SfmlTextAline::Atlas
+{
+	std::unique_ptr<sf::RenderTexture> texture; // replaced by a taller one (with the same contents) when full
+	unsigned int width{ 0u };
+	std::unordered_map<const sf::Texture*, std::unordered_map<std::uint64_t, sf::Vector2u>> glyphPositions; // key: font texture, then glyph's position in that texture
+	sf::Vector2u shelfPosition{ 0u, 0u }; // next free position on current shelf
+	unsigned int shelfHeight{ 0u };
+
+	// glyphs are packed in rows (shelves); a glyph's position never changes so layouts using the atlas stay valid as it grows
+	sf::Vector2u place(const sf::Vector2u size)
+	{
+		if ((shelfPosition.x + size.x) > width)
+		{
+			shelfPosition = { 0u, shelfPosition.y + shelfHeight };
+			shelfHeight = 0u;
+		}
+		const sf::Vector2u position{ shelfPosition };
+		shelfPosition.x += size.x;
+		shelfHeight = std::max(shelfHeight, size.y);
+		return position;
+	}
+
+	unsigned int getUsedHeight() const
+	{
+		return shelfPosition.y + shelfHeight;
+	}
+};
+
 SfmlTextAline::SfmlTextAline()
 	: m_font{ nullptr }
 	, m_string{ "" }
@@ -123,6 +383,45 @@ SfmlTextAline::SfmlTextAline()
 	, m_lineHeightMultiplier{ 1.f }
 	, m_letterSpacingMultiplier{ 0.f }
 	, m_isRoundingApplied{ true }
+	, m_isMonospace{ false }
+	, m_isTableLayout{ false }
+	, m_columnAlignments()
+	, m_columnDecimalPoints()
+	, m_source()
+	, m_sourceFirstLine{ 0u }
+	, m_sourceNumberOfLines{ defaultSourceNumberOfLines }
+	, m_visibleCharacterStart{ 0u }
+	, m_visibleCharacterLength{ allCharacters }
+	, m_characterAlphas()
+	, m_fallbackFonts()
+	, m_fontIndices()
+	, m_shaper()
+	, m_shapingCacheCapacity{ defaultShapingCacheCapacity }
+	, m_shapingCache()
+	, m_shapedString()
+	, m_isLayoutAsync{ false }
+	, m_layoutReadyCallback()
+	, m_asyncLayout()
+	, m_glyphTable{ nullptr }
+	, m_isLayoutShared{ false }
+	, m_sharedLayout()
+	, m_layoutCharacterBudget{ 0u }
+	, m_layoutTimeBudget{ sf::Time::Zero }
+	, m_layoutCursor()
+	, m_quadFontIndices()
+	, m_tableCells()
+	, m_atlas()
+	, m_isAtlasUsed{ false }
+	, m_isFallbackFontUsed{ false }
+	, m_laidOut()
+	, m_isCached{ false }
+	, m_cache()
+	, m_cacheVertices()
+	, m_isCacheUpdateRequired{ true }
+	, m_isVisibleRangeUpdateRequired{ true }
+	, m_visibleVertexStart{ 0u }
+	, m_visibleVertexCount{ 0u }
+	, m_characterQuadIndices()
 {
 }
 
@@ -155,26 +454,77 @@ void SfmlTextAline::operator=(const sf::Text& sfmlText)
 	setLineHeightMultiplier(sfmlText.getLineSpacing());
 	setLetterSpacingMultiplier((sfmlText.getLetterSpacing() - 1.f) / 3.f);
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
 }
 
 void SfmlTextAline::setFont(const sf::Font& font)
 {
+	if (m_font != &font)
+		m_fontIndices.clear();
 	SET_AND_UPDATE_MEMBER_IF_DIFFERENT_PTR(font);
 }
 
 void SfmlTextAline::setFont()
 {
 	m_font = nullptr;
+	m_fontIndices.clear();
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
+
+}
+void SfmlTextAline::addFallbackFont(const sf::Font& font)
+{
+	m_fallbackFonts.push_back(&font);
+	m_fontIndices.clear();
+
+	FLAG_UPDATE_REQUIRED();
+}
+
+void SfmlTextAline::removeFallbackFonts()
+{
+	m_fallbackFonts.clear();
+	m_fontIndices.clear();
 
+	FLAG_UPDATE_REQUIRED();
 }
+
 void SfmlTextAline::setString(const sf::String& string)
 {
+	m_source.reset();
 	SET_AND_UPDATE_MEMBER_IF_DIFFERENT(string);
 }
 
+bool SfmlTextAline::loadFromFile(const std::string& filename)
+{
+	auto source{ std::make_shared<Source>() };
+	if (!source->map(filename))
+		return false;
+	source->index();
+
+	m_source = std::move(source);
+	updateSourceString();
+	return true;
+}
+
+void SfmlTextAline::setSourceLineRange(const std::size_t firstLine, const std::size_t numberOfLines)
+{
+	m_sourceFirstLine = firstLine;
+	m_sourceNumberOfLines = numberOfLines;
+
+	if (m_source)
+		updateSourceString();
+}
+
+void SfmlTextAline::removeSourceLineRange()
+{
+	setSourceLineRange(0u, allLines);
+}
+
+void SfmlTextAline::removeSource()
+{
+	m_source.reset();
+}
+
 void SfmlTextAline::setCharacterSize(const std::size_t characterSize)
 {
 	SET_AND_UPDATE_MEMBER_IF_DIFFERENT(characterSize);
@@ -231,32 +581,173 @@ void SfmlTextAline::setIsRoundingApplied(const bool isRoundingApplied)
 	SET_AND_UPDATE_MEMBER_IF_DIFFERENT(isRoundingApplied);
 }
 
+void SfmlTextAline::setIsMonospace(const bool isMonospace)
+{
+	SET_AND_UPDATE_MEMBER_IF_DIFFERENT(isMonospace);
+}
+
+void SfmlTextAline::setIsMonospace()
+{
+	// monospace if narrow and wide characters all advance the same as a space
+	bool isMonospace{ false };
+	if (m_font != nullptr)
+	{
+		const unsigned int characterSize{ static_cast<unsigned int>(m_characterSize) };
+		const float spaceAdvance{ m_font->getGlyph(' ', characterSize, false).advance };
+		isMonospace = std::all_of(std::begin(monospaceTestCharacters), std::end(monospaceTestCharacters), [&](const std::uint32_t character) { return m_font->getGlyph(character, characterSize, false).advance == spaceAdvance; });
+	}
+	setIsMonospace(isMonospace);
+}
+
+void SfmlTextAline::setShaper(const Shaper& shaper)
+{
+	m_shaper = shaper;
+	m_shapingCache.clear();
+
+	FLAG_UPDATE_REQUIRED();
+}
+
+void SfmlTextAline::setShaper()
+{
+	if (!m_shaper)
+		return;
+
+	m_shaper = nullptr;
+	m_shapingCache.clear();
+	m_shapedString.clear();
+
+	FLAG_UPDATE_REQUIRED();
+}
+
+void SfmlTextAline::setShapingCacheCapacity(const std::size_t shapingCacheCapacity)
+{
+	m_shapingCacheCapacity = shapingCacheCapacity;
+	m_shapingCache.clear();
+}
+
+void SfmlTextAline::setIsLayoutAsync(const bool isLayoutAsync)
+{
+	m_isLayoutAsync = isLayoutAsync;
+}
+
+void SfmlTextAline::setLayoutReadyCallback(const std::function<void()>& layoutReadyCallback)
+{
+	m_layoutReadyCallback = layoutReadyCallback;
+}
+
+std::shared_future<void> SfmlTextAline::startLayout()
+{
+	if (m_isLayoutAsync)
+	{
+		updateAsyncLayout();
+		if (m_asyncLayout.job.valid())
+			return m_asyncLayout.job;
+	}
+	else
+		updateIfRequired();
+
+	std::promise<void> ready;
+	ready.set_value();
+	return ready.get_future().share();
+}
+
+void SfmlTextAline::setLayoutCharacterBudget(const std::size_t layoutCharacterBudget)
+{
+	m_layoutCharacterBudget = layoutCharacterBudget;
+}
+
+void SfmlTextAline::setLayoutTimeBudget(const sf::Time layoutTimeBudget)
+{
+	m_layoutTimeBudget = layoutTimeBudget;
+}
+
+void SfmlTextAline::removeLayoutBudget()
+{
+	m_layoutCharacterBudget = 0u;
+	m_layoutTimeBudget = sf::Time::Zero;
+}
+
+void SfmlTextAline::setIsLayoutShared(const bool isLayoutShared)
+{
+	SET_AND_UPDATE_MEMBER_IF_DIFFERENT(isLayoutShared);
+}
+
+void SfmlTextAline::setIsCached(const bool isCached)
+{
+	m_isCached = isCached;
+	m_isCacheUpdateRequired = true;
+
+	// release texture when not needed
+	if (!m_isCached)
+	{
+		m_cache.reset();
+		m_cacheVertices.clear();
+	}
+}
+
+void SfmlTextAline::setIsTableLayout(const bool isTableLayout)
+{
+	SET_AND_UPDATE_MEMBER_IF_DIFFERENT(isTableLayout);
+}
+
+void SfmlTextAline::setColumnAlignment(const std::size_t columnIndex, const Alignment alignment)
+{
+	m_columnAlignments[columnIndex] = alignment;
+	m_columnDecimalPoints.erase(columnIndex);
+
+	FLAG_UPDATE_REQUIRED();
+}
+
+void SfmlTextAline::setColumnDecimalAlignment(const std::size_t columnIndex, const std::uint32_t decimalPoint)
+{
+	m_columnAlignments.erase(columnIndex);
+	m_columnDecimalPoints[columnIndex] = decimalPoint;
+
+	FLAG_UPDATE_REQUIRED();
+}
+
+void SfmlTextAline::removeColumnAlignment(const std::size_t columnIndex)
+{
+	m_columnAlignments.erase(columnIndex);
+	m_columnDecimalPoints.erase(columnIndex);
+
+	FLAG_UPDATE_REQUIRED();
+}
+
+void SfmlTextAline::removeColumnAlignments()
+{
+	m_columnAlignments.clear();
+	m_columnDecimalPoints.clear();
+
+	FLAG_UPDATE_REQUIRED();
+}
+
 void SfmlTextAline::setLineAlignment(const std::size_t lineIndex, const Alignment alignment)
 {
 	m_lineAlignments[lineIndex] = alignment;
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
 }
 
 void SfmlTextAline::removeLineAlignment(const std::size_t lineIndex)
 {
 	m_lineAlignments.erase(lineIndex);
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
 }
 
 void SfmlTextAline::removeLineAlignments()
 {
 	m_lineAlignments.clear();
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
 }
 
 void SfmlTextAline::setLineOffset(const std::size_t lineIndex, const sf::Vector2f offset)
 {
 	m_lineOffsets[lineIndex] = offset;
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
 }
 
 void SfmlTextAline::setLineOffset(const std::size_t lineIndex, const float offset)
@@ -268,77 +759,122 @@ void SfmlTextAline::removeLineOffset(const std::size_t lineIndex)
 {
 	m_lineOffsets.erase(lineIndex);
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
 }
 
 void SfmlTextAline::removeLineOffsets()
 {
 	m_lineOffsets.clear();
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
 }
 
 void SfmlTextAline::setLineColor(const std::size_t lineIndex, const sf::Color color)
 {
 	m_lineColors[lineIndex] = color;
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
 }
 
 void SfmlTextAline::removeLineColor(const std::size_t lineIndex)
 {
 	m_lineColors.erase(lineIndex);
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
 }
 
 void SfmlTextAline::removeLineColors()
 {
 	m_lineColors.clear();
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
 }
 
 void SfmlTextAline::setLineBold(const std::size_t lineIndex, const bool bold)
 {
 	m_lineBolds[lineIndex] = bold;
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
 }
 
 void SfmlTextAline::removeLineBold(const std::size_t lineIndex)
 {
 	m_lineBolds.erase(lineIndex);
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
 }
 
 void SfmlTextAline::removeLineBolds()
 {
 	m_lineBolds.clear();
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
 }
 
 void SfmlTextAline::setLineItalic(const std::size_t lineIndex, const bool italic)
 {
 	m_lineItalics[lineIndex] = italic;
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
 }
 
 void SfmlTextAline::removeLineItalic(const std::size_t lineIndex)
 {
 	m_lineItalics.erase(lineIndex);
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
 }
 
 void SfmlTextAline::removeLineItalics()
 {
 	m_lineItalics.clear();
 
-	m_isUpdateRequired = true;
+	FLAG_UPDATE_REQUIRED();
+}
+
+void SfmlTextAline::setVisibleCharacterRange(const std::size_t start, const std::size_t length)
+{
+	m_visibleCharacterStart = start;
+	m_visibleCharacterLength = length;
+
+	m_isVisibleRangeUpdateRequired = true;
+}
+
+void SfmlTextAline::setVisibleCharacterCount(const std::size_t count)
+{
+	setVisibleCharacterRange(0u, count);
+}
+
+void SfmlTextAline::removeVisibleCharacterRange()
+{
+	setVisibleCharacterRange(0u, allCharacters);
+}
+
+void SfmlTextAline::setCharacterAlpha(const std::size_t characterIndex, const sf::Uint8 alpha)
+{
+	m_characterAlphas[characterIndex] = alpha;
+
+	// patch only the character's quad; a full update applies all alphas anyway (a shared layout cannot be patched so needs its own)
+	if (m_sharedLayout)
+		FLAG_UPDATE_REQUIRED();
+	else if (!m_isUpdateRequired)
+		applyCharacterAlpha(characterIndex, alpha);
+}
+
+void SfmlTextAline::removeCharacterAlpha(const std::size_t characterIndex)
+{
+	if ((m_characterAlphas.erase(characterIndex) > 0u) && !m_isUpdateRequired)
+		applyCharacterAlpha(characterIndex, 255u);
+}
+
+void SfmlTextAline::removeCharacterAlphas()
+{
+	if (!m_isUpdateRequired)
+	{
+		for (auto& characterAlpha : m_characterAlphas)
+			applyCharacterAlpha(characterAlpha.first, 255u);
+	}
+	m_characterAlphas.clear();
 }
 
 
@@ -351,10 +887,9 @@ void SfmlTextAline::removeLineItalics()
 
 std::size_t SfmlTextAline::getNumberOfLines() const
 {
-	if (m_isUpdateRequired)
-		updateVertices();
+	updateIfRequired();
 
-	return m_lines.size();
+	return getCurrentLines().size();
 }
 
 float SfmlTextAline::getLineSeparation() const
@@ -367,11 +902,36 @@ const sf::Font* SfmlTextAline::getFont() const
 	return m_font;
 }
 
+std::size_t SfmlTextAline::getNumberOfFallbackFonts() const
+{
+	return m_fallbackFonts.size();
+}
+
+const sf::Font* SfmlTextAline::getFallbackFont(const std::size_t fallbackIndex) const
+{
+	return (fallbackIndex < m_fallbackFonts.size()) ? m_fallbackFonts[fallbackIndex] : nullptr;
+}
+
 sf::String SfmlTextAline::getString() const
 {
 	return m_string;
 }
 
+std::size_t SfmlTextAline::getNumberOfSourceLines() const
+{
+	return m_source ? m_source->lineStarts.size() : 0u;
+}
+
+std::size_t SfmlTextAline::getSourceFirstLine() const
+{
+	return m_sourceFirstLine;
+}
+
+std::size_t SfmlTextAline::getSourceNumberOfLines() const
+{
+	return m_sourceNumberOfLines;
+}
+
 std::size_t SfmlTextAline::getCharacterSize() const
 {
 	return m_characterSize;
@@ -422,6 +982,68 @@ bool SfmlTextAline::getIsRoundingApplied() const
 	return m_isRoundingApplied;
 }
 
+bool SfmlTextAline::getIsMonospace() const
+{
+	return m_isMonospace;
+}
+
+bool SfmlTextAline::getIsShaped() const
+{
+	return static_cast<bool>(m_shaper);
+}
+
+std::size_t SfmlTextAline::getShapingCacheCapacity() const
+{
+	return m_shapingCacheCapacity;
+}
+
+bool SfmlTextAline::getIsLayoutAsync() const
+{
+	return m_isLayoutAsync;
+}
+
+bool SfmlTextAline::getIsLayoutPending() const
+{
+	return m_asyncLayout.job.valid() || m_asyncLayout.isCopiedWhilePending || m_isUpdateRequired;
+}
+
+std::size_t SfmlTextAline::getLayoutCharacterBudget() const
+{
+	return m_layoutCharacterBudget;
+}
+
+sf::Time SfmlTextAline::getLayoutTimeBudget() const
+{
+	return m_layoutTimeBudget;
+}
+
+bool SfmlTextAline::getIsLayoutShared() const
+{
+	return m_isLayoutShared;
+}
+
+
+bool SfmlTextAline::getIsCached() const
+{
+	return m_isCached;
+}
+
+bool SfmlTextAline::getIsTableLayout() const
+{
+	return m_isTableLayout;
+}
+
+SfmlTextAline::Alignment SfmlTextAline::getColumnAlignment(const std::size_t columnIndex) const
+{
+	auto it{ m_columnAlignments.find(columnIndex) };
+	return (it != m_columnAlignments.end()) ? it->second : Alignment::Left;
+}
+
+std::uint32_t SfmlTextAline::getColumnDecimalPoint(const std::size_t columnIndex) const
+{
+	auto it{ m_columnDecimalPoints.find(columnIndex) };
+	return (it != m_columnDecimalPoints.end()) ? it->second : 0u;
+}
 
 SfmlTextAline::Alignment SfmlTextAline::getLineAlignment(const std::size_t lineIndex) const
 {
@@ -453,17 +1075,96 @@ bool SfmlTextAline::getLineItalic(const std::size_t lineIndex) const
 	return (it != m_lineItalics.end()) ? it->second : ((m_textStyle & sf::Text::Style::Italic) == sf::Text::Style::Italic);
 }
 
-sf::FloatRect SfmlTextAline::getLocalBounds() const
+std::size_t SfmlTextAline::getVisibleCharacterStart() const
 {
-	updateVertices();
-	return m_localBounds;
+	return m_visibleCharacterStart;
 }
 
-sf::FloatRect SfmlTextAline::getGlobalBounds() const
+std::size_t SfmlTextAline::getVisibleCharacterLength() const
 {
-	return getTransform().transformRect(getLocalBounds());
+	return m_visibleCharacterLength;
 }
 
+sf::Uint8 SfmlTextAline::getCharacterAlpha(const std::size_t characterIndex) const
+{
+	auto it{ m_characterAlphas.find(characterIndex) };
+	return (it != m_characterAlphas.end()) ? it->second : sf::Uint8{ 255u };
+}
+
+sf::FloatRect SfmlTextAline::getLocalBounds() const
+{
+	updateIfRequired();
+	return m_localBounds;
+}
+
+sf::FloatRect SfmlTextAline::getGlobalBounds() const
+{
+	return getTransform().transformRect(getLocalBounds());
+}
+
+const std::vector<sf::Vertex>& SfmlTextAline::getVertices() const
+{
+	updateIfRequired();
+	return getCurrentVertices();
+}
+
+#ifdef SFMLTEXTALINE_ENABLE_STATISTICS
+SfmlTextAline::Statistics SfmlTextAline::getStatistics() const
+{
+	Statistics statistics;
+	statistics.rebuildCount = m_statistics.rebuildCount;
+	statistics.lastRebuildTime = m_statistics.lastRebuildTime;
+	statistics.averageRebuildTime = (m_statistics.rebuildCount > 0u) ? m_statistics.totalRebuildTime / static_cast<sf::Int64>(m_statistics.rebuildCount) : sf::Time::Zero;
+	statistics.glyphsEmitted = m_statistics.glyphsEmitted;
+	statistics.glyphLookups = m_statistics.glyphLookups;
+	statistics.kerningLookups = m_statistics.kerningLookups;
+	statistics.shapingCacheHits = m_statistics.shapingCacheHits;
+	statistics.shapingCacheMisses = m_statistics.shapingCacheMisses;
+	statistics.verticesResident = getCurrentVertices().size();
+	statistics.bytesAllocated = getBytesAllocated();
+	statistics.lastInvalidation = m_statistics.lastInvalidation;
+	return statistics;
+}
+
+std::size_t SfmlTextAline::getBytesAllocated() const
+{
+	std::size_t bytes{ 0u };
+
+	bytes += getVectorBytes(m_vertices) + getVectorBytes(m_lines) + getVectorBytes(m_quadFontIndices) + getVectorBytes(m_tableCells);
+	bytes += getVectorBytes(m_characterQuadIndices) + getVectorBytes(m_cacheVertices);
+	bytes += getStringBytes(m_laidOut.string) + getStringBytes(m_shapedString);
+	if (m_sharedLayout)
+		bytes += getVectorBytes(m_sharedLayout->vertices) + getVectorBytes(m_sharedLayout->lines);
+
+	for (auto& shapedRun : m_shapingCache.runs)
+		bytes += sizeof(shapedRun) + getStringBytes(shapedRun.key.run) + getStringBytes(shapedRun.shaped);
+	bytes += getMapBytes(m_shapingCache.positions);
+
+	if (m_atlas && m_atlas->texture)
+		bytes += getTextureBytes(m_atlas->texture->getSize());
+	if (m_cache)
+		bytes += getTextureBytes(m_cache->getSize());
+
+	if (m_asyncLayout.back)
+	{
+		bytes += getMapBytes(m_asyncLayout.glyphTable.glyphs) + getMapBytes(m_asyncLayout.glyphTable.kernings) + getMapBytes(m_asyncLayout.glyphTable.fontIndices);
+		if (!m_asyncLayout.job.valid()) // back buffer is in use by the job otherwise
+			bytes += m_asyncLayout.back->getBytesAllocated();
+	}
+
+	return bytes;
+}
+
+void SfmlTextAline::resetStatistics()
+{
+	const char* lastInvalidation{ m_statistics.lastInvalidation };
+	m_statistics = StatisticsCounters();
+	m_statistics.lastInvalidation = lastInvalidation;
+}
+#endif // SFMLTEXTALINE_ENABLE_STATISTICS
+
+
+
 
 
 
@@ -472,50 +1173,168 @@ sf::FloatRect SfmlTextAline::getGlobalBounds() const
 
 
 
-
-
 /// PRIVATE
 
 void SfmlTextAline::draw(sf::RenderTarget& target, sf::RenderStates states) const
 {
-	if (m_isUpdateRequired)
-		updateVertices();
+	SFMLTEXTALINE_PROFILE_ZONE("SfmlTextAline::draw");
+
+	if (m_isLayoutAsync)
+		updateAsyncLayout();
+	else
+		updateIfRequired(true);
+	if (m_isVisibleRangeUpdateRequired)
+		updateVisibleRange();
 
 	states.transform *= getTransform();
-	states.texture = ((m_font == nullptr) ? nullptr : &(m_font->getTexture(static_cast<unsigned int>(m_characterSize))));
 
-	target.draw(m_vertices.data(), m_vertices.size(), sf::PrimitiveType::Triangles, states);
+	if (getIsCacheDrawable(states))
+	{
+		if (m_isCacheUpdateRequired)
+			updateCache();
+		if (!m_cacheVertices.empty())
+		{
+			states.texture = &m_cache->getTexture();
+			states.blendMode = cacheDrawBlendMode;
+			target.draw(m_cacheVertices.data(), m_cacheVertices.size(), sf::PrimitiveType::Triangles, states);
+			return;
+		}
+	}
+
+	drawVertices(target, states, m_visibleVertexStart, m_visibleVertexCount);
+}
+
+void SfmlTextAline::drawVertices(sf::RenderTarget& target, sf::RenderStates states, const std::size_t vertexStart, const std::size_t numberOfVertices) const
+{
+	const sf::Vertex* vertices{ getCurrentVertices().data() };
+	const unsigned int characterSize{ static_cast<unsigned int>(m_laidOut.characterSize) };
+
+	if (m_isAtlasUsed)
+		states.texture = &m_atlas->texture->getTexture();
+	else if (!m_isFallbackFontUsed)
+		states.texture = ((m_laidOut.font == nullptr) ? nullptr : &(m_laidOut.font->getTexture(characterSize)));
+	else
+	{
+		// atlas could not be created so each run of glyphs from the same font is drawn with that font's texture
+		const std::size_t endQuad{ (vertexStart + numberOfVertices) / 6u };
+		for (std::size_t runStart{ vertexStart / 6u }; runStart < endQuad;)
+		{
+			const std::size_t fontIndex{ m_quadFontIndices[runStart] };
+			std::size_t runEnd{ runStart + 1u };
+			while ((runEnd < endQuad) && (m_quadFontIndices[runEnd] == fontIndex))
+				++runEnd;
+			const sf::Font& font{ (fontIndex == 0u) ? *m_laidOut.font : *m_laidOut.fallbackFonts[fontIndex - 1u] };
+			states.texture = &font.getTexture(characterSize);
+			target.draw(vertices + (runStart * 6u), (runEnd - runStart) * 6u, sf::PrimitiveType::Triangles, states);
+			runStart = runEnd;
+		}
+		return;
+	}
+
+	target.draw(vertices + vertexStart, numberOfVertices, sf::PrimitiveType::Triangles, states);
 }
 
-void SfmlTextAline::updateVertices() const
+void SfmlTextAline::updateVertices(const bool isWithinBudget) const
 {
-	if (m_font == nullptr || m_string.isEmpty())
+	SFMLTEXTALINE_PROFILE_ZONE("SfmlTextAline::updateVertices");
+
+	const bool isResuming{ m_layoutCursor.isInProgress };
+	const bool isBudgeted{ isWithinBudget && ((m_layoutCharacterBudget > 0u) || (m_layoutTimeBudget > sf::Time::Zero)) };
+
+	// clock is only read if layout time is limited or measured
+#ifdef SFMLTEXTALINE_ENABLE_STATISTICS
+	constexpr bool isClockRequired{ true };
+#else // SFMLTEXTALINE_ENABLE_STATISTICS
+	const bool isClockRequired{ isBudgeted && (m_layoutTimeBudget > sf::Time::Zero) };
+#endif // SFMLTEXTALINE_ENABLE_STATISTICS
+	std::optional<sf::Clock> layoutClock;
+	if (isClockRequired)
+		layoutClock.emplace();
+
+#ifdef SFMLTEXTALINE_ENABLE_STATISTICS
+	if (!isResuming)
+	{
+		m_statistics.glyphLookups = 0u;
+		m_statistics.kerningLookups = 0u;
+		m_statistics.shapingCacheHits = 0u;
+		m_statistics.shapingCacheMisses = 0u;
+		m_statistics.progressiveLayoutTime = sf::Time::Zero;
+	}
+	auto recordRebuild = [&](const std::size_t glyphsEmitted)
+	{
+		m_statistics.lastRebuildTime = m_statistics.progressiveLayoutTime + layoutClock->getElapsedTime();
+		m_statistics.totalRebuildTime += m_statistics.lastRebuildTime;
+		m_statistics.glyphsEmitted = glyphsEmitted;
+		++m_statistics.rebuildCount;
+	};
+#endif // SFMLTEXTALINE_ENABLE_STATISTICS
+
+	if (!isResuming)
+	{
+		m_sharedLayout.reset();
+		m_characterQuadIndices.clear();
+
+		if (m_shaper && (m_font != nullptr))
+			updateShapedString();
+	}
+	const sf::String& string{ getLayoutString() };
+	if (!isResuming)
+		m_laidOut = { m_font, m_fallbackFonts, m_characterSize, string };
+
+	if (!isResuming && (m_font == nullptr || string.isEmpty()))
 	{
 		m_vertices.clear();
+		m_lines.clear();
+		m_localBounds = sf::FloatRect();
+		m_isAtlasUsed = false;
+		m_isFallbackFontUsed = false;
 		m_isUpdateRequired = false;
+		m_isVisibleRangeUpdateRequired = true;
+		STATISTICS_ONLY(recordRebuild(0u));
 		return;
 	}
-	
 
+	// use identical layout if already shared
+	const bool isLayoutSharable{ m_isLayoutShared && m_characterAlphas.empty() && (m_glyphTable == nullptr) };
+	LayoutKey layoutKey;
+	if (isLayoutSharable && !isResuming)
+	{
+		layoutKey = createLayoutKey(string);
+		if (useSharedLayout(layoutKey))
+		{
+			m_isUpdateRequired = false;
+			m_isVisibleRangeUpdateRequired = true;
+			return;
+		}
+	}
 
-	m_vertices.resize(m_string.getSize() * 6u);
+	if (!isResuming)
+	{
+		m_vertices.resize(string.getSize() * 6u);
+		if (!m_fallbackFonts.empty())
+			m_quadFontIndices.resize(string.getSize());
+		m_lines.clear();
+		m_tableCells.clear();
+		m_layoutCursor = LayoutCursor();
+		m_layoutCursor.position = { 0.f, static_cast<float>(m_characterSize) };
+	}
 
-	std::size_t currentQuad{ 0u };
-	std::size_t numberOfUnusedQuads{ 0u };
+	// continue from cursor (start of text if not resuming)
+	std::size_t currentQuad{ m_layoutCursor.currentQuad };
+	std::size_t numberOfUnusedQuads{ m_layoutCursor.numberOfUnusedQuads };
 
 	// calculate global styles
 	const bool globalBold{ (m_textStyle & sf::Text::Style::Bold) == sf::Text::Style::Bold };
 	const bool globalItalic{ (m_textStyle & sf::Text::Style::Italic) == sf::Text::Style::Italic };
 	
-	const float lineHeight{ m_font->getLineSpacing(static_cast<unsigned int>(m_characterSize)) * m_lineHeightMultiplier };
-	sf::Vector2f position{ 0.f, static_cast<float>(m_characterSize) };
+	const float lineHeight{ ((m_glyphTable != nullptr) ? m_glyphTable->lineSpacing : getLineSeparation()) * m_lineHeightMultiplier };
+	sf::Vector2f position{ m_layoutCursor.position };
 
-	std::size_t currentLine{ 0u };
-	m_lines.clear();
+	std::size_t currentLine{ m_layoutCursor.currentLine };
 
-	float lineWidth{ 0.f };
-	std::size_t lineStartIndex{ 0u };
-	std::size_t lineStartQuad{ 0u };
+	float lineWidth{ m_layoutCursor.lineWidth };
+	std::size_t lineStartIndex{ m_layoutCursor.lineStartIndex };
+	std::size_t lineStartQuad{ m_layoutCursor.lineStartQuad };
 
 	auto saveLine = [&](std::size_t i)
 	{
@@ -540,16 +1359,76 @@ void SfmlTextAline::updateVertices() const
 		m_lines.push_back(line);
 	};
 
-	std::uint32_t prevChar{ 0u };
-	for (std::size_t i{ 0u }; i < m_string.getSize(); ++i)
+	std::uint32_t prevChar{ m_layoutCursor.prevChar };
+	std::size_t prevFontIndex{ m_layoutCursor.prevFontIndex };
+	std::size_t column{ m_layoutCursor.column }; // monospace only
+	std::size_t cellColumn{ m_layoutCursor.cellColumn }; // table layout only
+	std::size_t cellFirstQuad{ m_layoutCursor.cellFirstQuad };
+	float cellDecimalPosition{ m_layoutCursor.cellDecimalPosition };
+	std::uint32_t cellDecimalPoint{ m_isTableLayout ? getColumnDecimalPoint(cellColumn) : 0u };
+	auto saveCell = [&]()
 	{
-		std::uint32_t currentChar{ m_string[i] };
+		m_tableCells.push_back({ currentLine, cellColumn, cellFirstQuad, currentQuad - cellFirstQuad, position.x, cellDecimalPosition });
+	};
+	auto startCell = [&](const std::size_t columnIndex)
+	{
+		cellColumn = columnIndex;
+		cellFirstQuad = currentQuad;
+		cellDecimalPosition = -1.f;
+		cellDecimalPoint = getColumnDecimalPoint(cellColumn);
+	};
+	const std::size_t tabStopColumns{ std::max(m_tabLength, std::size_t{ 1u }) };
+	const std::size_t firstIndex{ m_layoutCursor.characterIndex };
+	for (std::size_t i{ firstIndex }; i < string.getSize(); ++i)
+	{
+		// progressive layout: save cursor and stop when budget is used (time is checked every few characters)
+		if (isBudgeted && (i > firstIndex))
+		{
+			const std::size_t numberOfCharactersDone{ i - firstIndex };
+			if (((m_layoutCharacterBudget > 0u) && (numberOfCharactersDone >= m_layoutCharacterBudget)) ||
+				((m_layoutTimeBudget > sf::Time::Zero) && ((numberOfCharactersDone % progressiveLayoutTimeCheckInterval) == 0u) && (layoutClock->getElapsedTime() >= m_layoutTimeBudget)))
+			{
+				m_layoutCursor.isInProgress = true;
+				m_layoutCursor.characterIndex = i;
+				m_layoutCursor.currentQuad = currentQuad;
+				m_layoutCursor.numberOfUnusedQuads = numberOfUnusedQuads;
+				m_layoutCursor.position = position;
+				m_layoutCursor.currentLine = currentLine;
+				m_layoutCursor.lineWidth = lineWidth;
+				m_layoutCursor.lineStartIndex = lineStartIndex;
+				m_layoutCursor.lineStartQuad = lineStartQuad;
+				m_layoutCursor.prevChar = prevChar;
+				m_layoutCursor.prevFontIndex = prevFontIndex;
+				m_layoutCursor.column = column;
+				m_layoutCursor.cellColumn = cellColumn;
+				m_layoutCursor.cellFirstQuad = cellFirstQuad;
+				m_layoutCursor.cellDecimalPosition = cellDecimalPosition;
+
+				// completed lines can be drawn (unaligned) until the layout is complete
+				for (; m_layoutCursor.numberOfColoredLines < m_lines.size(); ++m_layoutCursor.numberOfColoredLines)
+				{
+					const Line& line{ m_lines[m_layoutCursor.numberOfColoredLines] };
+					for (std::size_t v{ 0u }; v < (line.numberOfQuads * 6u); ++v)
+						m_vertices[line.vertexIndex + v].color = line.color;
+				}
+				m_isVisibleRangeUpdateRequired = true;
+				STATISTICS_ONLY(m_statistics.progressiveLayoutTime += layoutClock->getElapsedTime());
+				return;
+			}
+		}
+
+		std::uint32_t currentChar{ string[i] };
 
 		lineWidth = std::max(lineWidth, position.x);
 
-		// kerning
-		position.x += m_font->getKerning(prevChar, currentChar, static_cast<unsigned int>(m_characterSize));
+		// font (main or fallback)
+		const std::size_t fontIndex{ (m_fallbackFonts.empty() || isWhitespace(currentChar)) ? 0u : getFontIndex(currentChar) };
+
+		// kerning (only between characters from the same font)
+		if (!m_isMonospace && (fontIndex == prevFontIndex))
+			position.x += getKerning(fontIndex, prevChar, currentChar);
 		prevChar = currentChar;
+		prevFontIndex = fontIndex;
 
 		// calculate bold
 		bool bold{ globalBold };
@@ -562,8 +1441,9 @@ void SfmlTextAline::updateVertices() const
 			italic = it->second;
 
 		// calculate spacing
-		const float spaceWidth{ m_font->getGlyph(' ', static_cast<unsigned int>(m_characterSize), bold).advance };
+		const float spaceWidth{ getGlyph(0u, ' ', bold).advance };
 		const float letterSpacing{ spaceWidth * m_letterSpacingMultiplier };
+		const float columnWidth{ spaceWidth + letterSpacing }; // monospace only
 
 		// whitespace
 		if ((currentChar == ' ') || (currentChar == '\n') || (currentChar == '\t'))
@@ -571,18 +1451,41 @@ void SfmlTextAline::updateVertices() const
 			switch (currentChar)
 			{
 			case ' ':
-				position.x += spaceWidth + letterSpacing;
+				if (m_isMonospace)
+					position.x = static_cast<float>(++column) * columnWidth;
+				else
+					position.x += spaceWidth + letterSpacing;
 				break;
 			case '\t':
-				position.x += (spaceWidth * m_tabLength) + letterSpacing;
+				if (m_isTableLayout)
+				{
+					// each cell is laid out from zero and moved into its column afterwards
+					saveCell();
+					startCell(cellColumn + 1u);
+					position.x = 0.f;
+					column = 0u;
+				}
+				else if (m_isMonospace)
+				{
+					column = ((column / tabStopColumns) + 1u) * tabStopColumns;
+					position.x = static_cast<float>(column) * columnWidth;
+				}
+				else
+					position.x += (spaceWidth * m_tabLength) + letterSpacing;
 				break;
 			case '\n':
+				if (m_isTableLayout)
+				{
+					saveCell();
+					startCell(0u);
+				}
 				saveLine(i);
 				lineWidth = 0.f;
 				lineStartIndex = i + 1u;
 				lineStartQuad = currentQuad;
 				position.y += lineHeight;
 				position.x = 0.f;
+				column = 0u;
 				++currentLine;
 				break;
 			}
@@ -592,21 +1495,47 @@ void SfmlTextAline::updateVertices() const
 		}
 
 		// glyph character
-		const sf::Glyph& glyph = m_font->getGlyph(currentChar, static_cast<unsigned int>(m_characterSize), bold);
+		const sf::Glyph& glyph = getGlyph(fontIndex, currentChar, bold);
+		if (!m_fallbackFonts.empty())
+			m_quadFontIndices[currentQuad] = fontIndex;
+		if ((cellDecimalPoint != 0u) && (currentChar == cellDecimalPoint) && (cellDecimalPosition < 0.f))
+			cellDecimalPosition = position.x;
 		::setGlyph(m_vertices, currentQuad, glyph, position, italic ? m_italicShear : 0.f);
 
-		position.x += glyph.advance + letterSpacing;
+		if (m_isMonospace)
+			position.x = static_cast<float>(++column) * columnWidth;
+		else
+			position.x += glyph.advance + letterSpacing;
 
 		// final line
-		if (i == (m_string.getSize() - 1u))
+		if (i == (string.getSize() - 1u))
 		{
 			lineWidth = std::max(lineWidth, position.x);
-			saveLine(i);
+			if (m_isTableLayout)
+				saveCell();
+			saveLine(i + 1u);
 		}
 	}
 
+	// final line (and cell) are not saved by the loop if they end with whitespace
+	if (!string.isEmpty() && isWhitespace(string[string.getSize() - 1u]) && (string[string.getSize() - 1u] != '\n'))
+	{
+		lineWidth = std::max(lineWidth, position.x);
+		if (m_isTableLayout)
+			saveCell();
+		saveLine(string.getSize());
+	}
+
 	// remove unused quads from vector
-	m_vertices.resize((m_string.getSize() - numberOfUnusedQuads) * 6u);
+	m_vertices.resize((string.getSize() - numberOfUnusedQuads) * 6u);
+
+	// move cells into their columns
+	if (m_isTableLayout)
+		updateTableLayout();
+
+	// combine fonts' textures if any fallback font was used (textures cannot be used from an async layout's worker thread)
+	if (m_glyphTable == nullptr)
+		updateAtlas();
 
 	// calculate which line (or minimum width) is longest
 	float maxLineWidth{ m_minWidth };
@@ -625,9 +1554,14 @@ void SfmlTextAline::updateVertices() const
 	{
 		sf::Vector2f offset{ m_lines[l].offset };
 		float justifyOffset{ 0.f };
+
+		// justifying a table's line would move its cells out of their columns
+		const bool isJustified{ (m_lines[l].alignment == Alignment::JustifyWhitespace) || (m_lines[l].alignment == Alignment::JustifyCharacters) };
+		const Alignment alignment{ (m_isTableLayout && isJustified) ? Alignment::Left : m_lines[l].alignment };
+
 		if (l != longestLine)
 		{
-			switch (m_lines[l].alignment)
+			switch (alignment)
 			{
 			case Alignment::Right:
 				offset.x += m_isRoundingApplied ? std::round(maxLineWidth - m_lines[l].width) : maxLineWidth - m_lines[l].width;
@@ -643,14 +1577,14 @@ void SfmlTextAline::updateVertices() const
 			}
 		}
 
-		if (m_lines[l].alignment == Alignment::JustifyWhitespace)
+		if (alignment == Alignment::JustifyWhitespace)
 		{
 			bool inWhiteSpaceBlock{ false };
 			std::size_t numberOfWhitespaceBlocks{ 0u };
 			for (std::size_t i{ 0u }; i < m_lines[l].length; ++i)
 			{
 				const std::size_t currentIndex{ m_lines[l].start + i };
-				const std::uint32_t currentChar{ m_string[currentIndex] };
+				const std::uint32_t currentChar{ string[currentIndex] };
 				if (currentChar == ' ' || currentChar == '\t')
 				{
 					if (!inWhiteSpaceBlock)
@@ -669,7 +1603,7 @@ void SfmlTextAline::updateVertices() const
 			for (std::size_t i{ 0u }; i < m_lines[l].length; ++i)
 			{
 				const std::size_t currentIndex{ m_lines[l].start + i };
-				const std::uint32_t currentChar{ m_string[currentIndex] };
+				const std::uint32_t currentChar{ string[currentIndex] };
 				
 				if (currentChar == ' ' || currentChar == '\t')
 				{
@@ -689,7 +1623,7 @@ void SfmlTextAline::updateVertices() const
 				}
 			}
 		}
-		else if (m_lines[l].alignment == Alignment::JustifyCharacters)
+		else if (alignment == Alignment::JustifyCharacters)
 		{
 			justifyOffset = (m_lines[l].length > 2u) ? (maxLineWidth - m_lines[l].width) / (static_cast<float>(m_lines[l].length) - 1.f) : 0.f;
 
@@ -698,7 +1632,7 @@ void SfmlTextAline::updateVertices() const
 			for (std::size_t i{ 0u }; i < m_lines[l].length; ++i)
 			{
 				const std::size_t currentIndex{ m_lines[l].start + i };
-				const std::uint32_t currentChar{ m_string[currentIndex] };
+				const std::uint32_t currentChar{ string[currentIndex] };
 
 				if (!(currentChar == ' ' || currentChar == '\t'))
 				{
@@ -739,6 +1673,894 @@ void SfmlTextAline::updateVertices() const
 	m_localBounds.width = max.x - m_localBounds.left;
 	m_localBounds.height = max.y - m_localBounds.top;
 
+	// apply individual character alphas
+	for (auto& characterAlpha : m_characterAlphas)
+		applyCharacterAlpha(characterAlpha.first, characterAlpha.second);
+
+	if (isLayoutSharable && (m_isAtlasUsed || !m_isFallbackFontUsed))
+		shareLayout(isResuming ? createLayoutKey(string) : std::move(layoutKey));
+
 	// all done
+	m_layoutCursor.isInProgress = false;
+	m_isUpdateRequired = false;
+	m_isVisibleRangeUpdateRequired = true;
+	STATISTICS_ONLY(recordRebuild(currentQuad));
+}
+
+void SfmlTextAline::updateVisibleRange() const
+{
+	m_isVisibleRangeUpdateRequired = false;
+	m_isCacheUpdateRequired = true;
+
+	// only completed lines are drawn while a progressive layout is in progress
+	const std::size_t numberOfVertices{ m_layoutCursor.isInProgress ? (m_layoutCursor.lineStartQuad * 6u) : getCurrentVertices().size() };
+
+	if ((m_visibleCharacterStart == 0u) && (m_visibleCharacterLength == allCharacters))
+	{
+		m_visibleVertexStart = 0u;
+		m_visibleVertexCount = numberOfVertices;
+		return;
+	}
+
+	const std::size_t numberOfCharacters{ m_laidOut.string.getSize() };
+	const std::size_t start{ std::min(m_visibleCharacterStart, numberOfCharacters) };
+	const std::size_t end{ start + std::min(m_visibleCharacterLength, numberOfCharacters - start) };
+
+	const std::size_t startQuad{ getCharacterQuadIndex(start) };
+	m_visibleVertexStart = std::min(startQuad * 6u, numberOfVertices);
+	m_visibleVertexCount = std::min((getCharacterQuadIndex(end) - startQuad) * 6u, numberOfVertices - m_visibleVertexStart);
+}
+
+void SfmlTextAline::applyCharacterAlpha(const std::size_t characterIndex, const sf::Uint8 alpha) const
+{
+	const sf::String& string{ m_laidOut.string };
+	if ((characterIndex >= string.getSize()) || isWhitespace(string[characterIndex]))
+		return;
+
+	const std::size_t vertexIndex{ getCharacterQuadIndex(characterIndex) * 6u };
+	if (vertexIndex >= m_vertices.size())
+		return;
+
+	// find line containing the quad (lines are ordered by vertex index)
+	auto line{ std::upper_bound(m_lines.begin(), m_lines.end(), vertexIndex, [](const std::size_t index, const Line& line) { return index < line.vertexIndex; }) };
+	if (line == m_lines.begin())
+		return;
+	--line;
+
+	sf::Color color{ line->color };
+	color.a = static_cast<sf::Uint8>((static_cast<unsigned int>(color.a) * alpha) / 255u);
+	for (std::size_t v{ 0u }; v < 6u; ++v)
+		m_vertices[vertexIndex + v].color = color;
+	m_isCacheUpdateRequired = true;
+}
+
+std::size_t SfmlTextAline::getCharacterQuadIndex(const std::size_t characterIndex) const
+{
+	// whitespace does not create a quad so a character's quad index is the number of glyphs before it (counted once per layout)
+	if (m_characterQuadIndices.empty())
+	{
+		const sf::String& string{ m_laidOut.string };
+		m_characterQuadIndices.resize(string.getSize() + 1u);
+		std::size_t numberOfQuads{ 0u };
+		for (std::size_t i{ 0u }; i < string.getSize(); ++i)
+		{
+			m_characterQuadIndices[i] = numberOfQuads;
+			if (!isWhitespace(string[i]))
+				++numberOfQuads;
+		}
+		m_characterQuadIndices.back() = numberOfQuads;
+	}
+	return m_characterQuadIndices[std::min(characterIndex, m_characterQuadIndices.size() - 1u)];
+}
+
+void SfmlTextAline::updateAtlas() const
+{
+	m_isAtlasUsed = false;
+	const std::size_t numberOfQuads{ m_vertices.size() / 6u };
+	m_isFallbackFontUsed = !m_fallbackFonts.empty() && std::any_of(m_quadFontIndices.begin(), m_quadFontIndices.begin() + numberOfQuads, [](const std::size_t fontIndex) { return fontIndex != 0u; });
+	if (!m_isFallbackFontUsed)
+		return;
+
+	const unsigned int characterSize{ static_cast<unsigned int>(m_characterSize) };
+	std::vector<const sf::Texture*> fontTextures(m_fallbackFonts.size() + 1u);
+	for (std::size_t f{ 0u }; f < fontTextures.size(); ++f)
+		fontTextures[f] = &getFontByIndex(f).getTexture(characterSize);
+
+	// quad's glyph's rectangle in its font's texture
+	auto getTextureRect = [&](const std::size_t quad)
+	{
+		const sf::Vector2f topLeft{ m_vertices[quad * 6u].texCoords };
+		const sf::Vector2f bottomRight{ m_vertices[quad * 6u + 3u].texCoords };
+		return sf::IntRect(static_cast<int>(topLeft.x), static_cast<int>(topLeft.y), static_cast<int>(bottomRight.x - topLeft.x), static_cast<int>(bottomRight.y - topLeft.y));
+	};
+
+	// start a new atlas if there is none or a glyph does not fit its width
+	unsigned int requiredWidth{ minimumAtlasWidth };
+	for (std::size_t q{ 0u }; q < numberOfQuads; ++q)
+		requiredWidth = std::max(requiredWidth, static_cast<unsigned int>(getTextureRect(q).width) + (atlasGlyphPadding * 2u));
+	if (!m_atlas || (m_atlas->width < requiredWidth))
+	{
+		m_atlas = std::make_shared<Atlas>();
+		m_atlas->width = getPowerOfTwo(requiredWidth);
+	}
+	Atlas& atlas{ *m_atlas };
+
+	// place glyphs that are not already in the atlas
+	struct NewGlyph
+	{
+		const sf::Texture* fontTexture;
+		sf::IntRect textureRect;
+		sf::Vector2u position;
+	};
+	std::vector<NewGlyph> newGlyphs;
+	const sf::Vector2u previousShelfPosition{ atlas.shelfPosition };
+	const unsigned int previousShelfHeight{ atlas.shelfHeight };
+	for (std::size_t q{ 0u }; q < numberOfQuads; ++q)
+	{
+		const sf::Texture* fontTexture{ fontTextures[m_quadFontIndices[q]] };
+		const sf::IntRect textureRect{ getTextureRect(q) };
+		if (auto [it, isInserted] { atlas.glyphPositions[fontTexture].emplace(::getAtlasGlyphKey(textureRect), sf::Vector2u()) }; isInserted)
+		{
+			it->second = atlas.place({ static_cast<unsigned int>(textureRect.width) + (atlasGlyphPadding * 2u), static_cast<unsigned int>(textureRect.height) + (atlasGlyphPadding * 2u) });
+			newGlyphs.push_back({ fontTexture, textureRect, it->second });
+		}
+	}
+
+	// grow texture (keeping its contents) if the new glyphs do not fit
+	const unsigned int requiredHeight{ std::max(atlas.getUsedHeight(), minimumAtlasHeight) };
+	if (!atlas.texture || (atlas.texture->getSize().y < requiredHeight))
+	{
+		const unsigned int height{ getPowerOfTwo(requiredHeight) };
+		auto texture{ std::make_unique<sf::RenderTexture>() };
+		if ((atlas.width > sf::Texture::getMaximumSize()) || (height > sf::Texture::getMaximumSize()) || !texture->create(atlas.width, height))
+		{
+			// glyphs are drawn from their fonts' textures instead
+			for (auto& newGlyph : newGlyphs)
+				atlas.glyphPositions[newGlyph.fontTexture].erase(::getAtlasGlyphKey(newGlyph.textureRect));
+			atlas.shelfPosition = previousShelfPosition;
+			atlas.shelfHeight = previousShelfHeight;
+			return;
+		}
+		texture->clear(sf::Color::Transparent);
+		if (atlas.texture)
+		{
+			const sf::Vector2f previousSize{ sf::Vector2f(atlas.texture->getSize()) };
+			const sf::Vertex previousVertices[6u]
+			{
+				{ { 0.f, 0.f }, sf::Color::White, { 0.f, 0.f } },
+				{ { 0.f, previousSize.y }, sf::Color::White, { 0.f, previousSize.y } },
+				{ { previousSize.x, 0.f }, sf::Color::White, { previousSize.x, 0.f } },
+				{ { previousSize.x, previousSize.y }, sf::Color::White, previousSize },
+				{ { previousSize.x, 0.f }, sf::Color::White, { previousSize.x, 0.f } },
+				{ { 0.f, previousSize.y }, sf::Color::White, { 0.f, previousSize.y } },
+			};
+			sf::RenderStates states{ &atlas.texture->getTexture() };
+			states.blendMode = sf::BlendNone;
+			texture->draw(previousVertices, 6u, sf::PrimitiveType::Triangles, states);
+		}
+		atlas.texture = std::move(texture);
+	}
+	atlas.texture->setSmooth(fontTextures[0u]->isSmooth());
+
+	// copy new glyphs (with their transparent borders) from their fonts' textures; one draw per font
+	if (!newGlyphs.empty())
+	{
+		for (std::size_t f{ 0u }; f < fontTextures.size(); ++f)
+		{
+			std::vector<sf::Vertex> copyVertices;
+			for (auto& newGlyph : newGlyphs)
+			{
+				if (newGlyph.fontTexture != fontTextures[f])
+					continue;
+				const sf::Vector2f size{ static_cast<float>(newGlyph.textureRect.width + static_cast<int>(atlasGlyphPadding * 2u)), static_cast<float>(newGlyph.textureRect.height + static_cast<int>(atlasGlyphPadding * 2u)) };
+				const sf::Vector2f position{ sf::Vector2f(newGlyph.position) };
+				const sf::Vector2f texturePosition{ static_cast<float>(newGlyph.textureRect.left) - atlasGlyphPadding, static_cast<float>(newGlyph.textureRect.top) - atlasGlyphPadding };
+				copyVertices.push_back({ position, sf::Color::White, texturePosition });
+				copyVertices.push_back({ { position.x, position.y + size.y }, sf::Color::White, { texturePosition.x, texturePosition.y + size.y } });
+				copyVertices.push_back({ { position.x + size.x, position.y }, sf::Color::White, { texturePosition.x + size.x, texturePosition.y } });
+				copyVertices.push_back({ position + size, sf::Color::White, texturePosition + size });
+				copyVertices.push_back(copyVertices[copyVertices.size() - 2u]);
+				copyVertices.push_back(copyVertices[copyVertices.size() - 4u]);
+			}
+			if (copyVertices.empty())
+				continue;
+			sf::RenderStates states{ fontTextures[f] };
+			states.blendMode = sf::BlendNone;
+			atlas.texture->draw(copyVertices.data(), copyVertices.size(), sf::PrimitiveType::Triangles, states);
+		}
+		atlas.texture->display();
+	}
+
+	// move texture co-ordinates to the glyphs' positions in the atlas
+	for (std::size_t q{ 0u }; q < numberOfQuads; ++q)
+	{
+		const sf::IntRect textureRect{ getTextureRect(q) };
+		const sf::Vector2u position{ atlas.glyphPositions[fontTextures[m_quadFontIndices[q]]][::getAtlasGlyphKey(textureRect)] };
+		const sf::Vector2f textureOffset{ static_cast<float>(position.x + atlasGlyphPadding) - textureRect.left, static_cast<float>(position.y + atlasGlyphPadding) - textureRect.top };
+		for (std::size_t v{ 0u }; v < 6u; ++v)
+			m_vertices[q * 6u + v].texCoords += textureOffset;
+	}
+
+	m_isAtlasUsed = true;
+}
+
+bool SfmlTextAline::getIsCacheDrawable(const sf::RenderStates& states) const
+{
+	if (!m_isCached || m_layoutCursor.isInProgress || (states.shader != nullptr) || (states.blendMode != sf::BlendAlpha))
+		return false;
+
+	// cache is only pixel-exact if its texels map to pixels so anything other than translation would blur it
+	const float* matrix{ states.transform.getMatrix() };
+	return (std::abs(matrix[0] - 1.f) < cacheTransformEpsilon)
+		&& (std::abs(matrix[1]) < cacheTransformEpsilon)
+		&& (std::abs(matrix[4]) < cacheTransformEpsilon)
+		&& (std::abs(matrix[5] - 1.f) < cacheTransformEpsilon);
+}
+
+void SfmlTextAline::updateCache() const
+{
+	m_isCacheUpdateRequired = false;
+	m_cacheVertices.clear();
+
+	if (m_visibleVertexCount == 0u)
+		return;
+
+	// bounds of visible vertices, expanded to whole pixels
+	const sf::Vertex* vertices{ getCurrentVertices().data() + m_visibleVertexStart };
+	sf::Vector2f min{ vertices[0u].position };
+	sf::Vector2f max{ min };
+	for (std::size_t v{ 1u }; v < m_visibleVertexCount; ++v)
+	{
+		min.x = std::min(min.x, vertices[v].position.x);
+		min.y = std::min(min.y, vertices[v].position.y);
+		max.x = std::max(max.x, vertices[v].position.x);
+		max.y = std::max(max.y, vertices[v].position.y);
+	}
+	min = { std::floor(min.x), std::floor(min.y) };
+	const sf::Vector2u size{ static_cast<unsigned int>(std::ceil(max.x - min.x)), static_cast<unsigned int>(std::ceil(max.y - min.y)) };
+	if ((size.x == 0u) || (size.y == 0u) || (size.x > sf::Texture::getMaximumSize()) || (size.y > sf::Texture::getMaximumSize()))
+		return;
+
+	// (re-)create render texture if it is too small or is still shared with a copy
+	if (!m_cache || (m_cache.use_count() > 1) || (m_cache->getSize().x < size.x) || (m_cache->getSize().y < size.y))
+	{
+		m_cache = std::make_shared<sf::RenderTexture>();
+		if (!m_cache->create(size.x, size.y))
+		{
+			m_cache.reset();
+			return;
+		}
+	}
+
+	sf::RenderStates states;
+	states.blendMode = cacheRenderBlendMode;
+	m_cache->setView(sf::View({ min, sf::Vector2f(m_cache->getSize()) }));
+	m_cache->clear(sf::Color::Transparent);
+	drawVertices(*m_cache, states, m_visibleVertexStart, m_visibleVertexCount);
+	m_cache->display();
+
+	const sf::Vector2f sizeF{ sf::Vector2f(size) };
+	const sf::Vector2f topLeft{ min };
+	const sf::Vector2f topRight{ min.x + sizeF.x, min.y };
+	const sf::Vector2f bottomLeft{ min.x, min.y + sizeF.y };
+	const sf::Vector2f bottomRight{ min + sizeF };
+	m_cacheVertices =
+	{
+		{ topLeft, sf::Color::White, { 0.f, 0.f } },
+		{ bottomLeft, sf::Color::White, { 0.f, sizeF.y } },
+		{ topRight, sf::Color::White, { sizeF.x, 0.f } },
+		{ bottomLeft, sf::Color::White, { 0.f, sizeF.y } },
+		{ bottomRight, sf::Color::White, sizeF },
+		{ topRight, sf::Color::White, { sizeF.x, 0.f } },
+	};
+}
+
+void SfmlTextAline::updateTableLayout() const
+{
+	// column widths (and widths either side of decimal points) from all cells
+	struct Column
+	{
+		float width{ 0.f };
+		float decimalLeft{ 0.f };
+		float decimalRight{ 0.f };
+		float position{ 0.f };
+	};
+	std::vector<Column> columns;
+	for (auto& cell : m_tableCells)
+	{
+		if (cell.column >= columns.size())
+			columns.resize(cell.column + 1u);
+		Column& column{ columns[cell.column] };
+		if (getColumnDecimalPoint(cell.column) != 0u)
+		{
+			// a cell without a decimal point is aligned as if it is at its end
+			const float decimalPosition{ (cell.decimalPosition < 0.f) ? cell.width : cell.decimalPosition };
+			column.decimalLeft = std::max(column.decimalLeft, decimalPosition);
+			column.decimalRight = std::max(column.decimalRight, cell.width - decimalPosition);
+			column.width = std::max(column.width, column.decimalLeft + column.decimalRight);
+		}
+		else
+			column.width = std::max(column.width, cell.width);
+	}
+
+	// columns are separated by the tab length (in spaces)
+	const float columnGap{ (m_font == nullptr) ? 0.f : getGlyph(0u, ' ', false).advance * static_cast<float>(m_tabLength) };
+	for (std::size_t c{ 1u }; c < columns.size(); ++c)
+		columns[c].position = columns[c - 1u].position + columns[c - 1u].width + columnGap;
+
+	for (auto& cell : m_tableCells)
+	{
+		const Column& column{ columns[cell.column] };
+		float offset{ 0.f };
+		if (getColumnDecimalPoint(cell.column) != 0u)
+			offset = column.decimalLeft - ((cell.decimalPosition < 0.f) ? cell.width : cell.decimalPosition);
+		else
+		{
+			switch (getColumnAlignment(cell.column))
+			{
+			case Alignment::Right:
+				offset = column.width - cell.width;
+				break;
+			case Alignment::Center:
+				offset = (column.width - cell.width) / 2.f;
+				break;
+			case Alignment::Left:
+			case Alignment::JustifyCharacters:
+			case Alignment::JustifyWhitespace:
+			default:
+				break;
+			}
+		}
+		offset = column.position + (m_isRoundingApplied ? std::round(offset) : offset);
+
+		for (std::size_t v{ 0u }; v < (cell.numberOfQuads * 6u); ++v)
+			m_vertices[(cell.firstQuad * 6u) + v].position.x += offset;
+	}
+
+	// every line is as wide as the table so that line alignment moves all rows together
+	const float tableWidth{ columns.empty() ? 0.f : (columns.back().position + columns.back().width) };
+	for (auto& line : m_lines)
+		line.width = tableWidth;
+}
+
+std::size_t SfmlTextAline::getFontIndex(const std::uint32_t character) const
+{
+	if (m_glyphTable != nullptr)
+		return m_glyphTable->fontIndices.at(character);
+
+	if (auto it{ m_fontIndices.find(character) }; it != m_fontIndices.end())
+		return it->second;
+
+	std::size_t fontIndex{ 0u };
+	if (!m_font->hasGlyph(character))
+	{
+		for (std::size_t f{ 0u }; f < m_fallbackFonts.size(); ++f)
+		{
+			if (m_fallbackFonts[f]->hasGlyph(character))
+			{
+				fontIndex = f + 1u;
+				break;
+			}
+		}
+	}
+	m_fontIndices.emplace(character, fontIndex);
+	return fontIndex;
+}
+
+const sf::Font& SfmlTextAline::getFontByIndex(const std::size_t fontIndex) const
+{
+	return (fontIndex == 0u) ? *m_font : *m_fallbackFonts[fontIndex - 1u];
+}
+
+void SfmlTextAline::updateIfRequired(const bool isWithinBudget) const
+{
+	flagUpdateIfCopiedWhilePending();
+	if (m_asyncLayout.job.valid())
+		finishAsyncLayout();
+	if (m_isUpdateRequired)
+		updateVertices(isWithinBudget);
+}
+
+void SfmlTextAline::updateAsyncLayout() const
+{
+	flagUpdateIfCopiedWhilePending();
+	if (m_asyncLayout.job.valid())
+	{
+		if (m_asyncLayout.job.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return;
+		finishAsyncLayout();
+	}
+	if (m_isUpdateRequired)
+		startAsyncLayout();
+}
+
+void SfmlTextAline::flagUpdateIfCopiedWhilePending() const
+{
+	// the copied layout is for the previous settings (and the source's job is not copied) so the copy's update flag is not valid
+	if (!m_asyncLayout.isCopiedWhilePending)
+		return;
+	m_asyncLayout.isCopiedWhilePending = false;
+	FLAG_UPDATE_REQUIRED();
+}
+
+void SfmlTextAline::startAsyncLayout() const
+{
+#ifdef SFMLTEXTALINE_ENABLE_STATISTICS
+	m_statistics.glyphLookups = 0u;
+	m_statistics.kerningLookups = 0u;
+	m_statistics.shapingCacheHits = 0u;
+	m_statistics.shapingCacheMisses = 0u;
+#endif // SFMLTEXTALINE_ENABLE_STATISTICS
+
+	// shaping, font choice and glyph loading use the fonts (and their textures) so must be done on this thread
+	if (m_shaper && (m_font != nullptr))
+		updateShapedString();
+
+	if (!m_asyncLayout.back)
+		m_asyncLayout.back = std::make_unique<SfmlTextAline>();
+	SfmlTextAline& back{ *m_asyncLayout.back };
+
+	// only settings are given to the back buffer; it keeps its own buffers and atlas
+	back.setLayoutSettings(createLayoutKey(getLayoutString()));
+
+	if (m_font != nullptr)
+		prepareGlyphTable(m_asyncLayout.glyphTable, back.m_string);
+	back.m_glyphTable = &m_asyncLayout.glyphTable;
+
+	// job replaces a progressive layout that is in progress; its completed lines are drawn until the job finishes
+	if (m_layoutCursor.isInProgress)
+	{
+		m_vertices.resize(m_layoutCursor.lineStartQuad * 6u);
+		m_isVisibleRangeUpdateRequired = true;
+	}
+	m_layoutCursor = LayoutCursor();
+
 	m_isUpdateRequired = false;
+	m_asyncLayout.job = std::async(std::launch::async, [&back, layoutReadyCallback{ m_layoutReadyCallback }]()
+	{
+		back.updateVertices();
+		if (layoutReadyCallback)
+			layoutReadyCallback();
+	}).share();
+}
+
+void SfmlTextAline::finishAsyncLayout() const
+{
+	m_asyncLayout.job.get();
+	m_asyncLayout.job = std::shared_future<void>();
+
+	SfmlTextAline& back{ *m_asyncLayout.back };
+	back.updateAtlas();
+
+	// swap buffers
+	m_sharedLayout.reset();
+	m_vertices.swap(back.m_vertices);
+	m_lines.swap(back.m_lines);
+	m_quadFontIndices.swap(back.m_quadFontIndices);
+	m_characterQuadIndices.clear();
+	m_atlas.swap(back.m_atlas);
+	std::swap(m_laidOut, back.m_laidOut);
+	m_isAtlasUsed = back.m_isAtlasUsed;
+	m_isFallbackFontUsed = back.m_isFallbackFontUsed;
+	m_localBounds = back.m_localBounds;
+
+#ifdef SFMLTEXTALINE_ENABLE_STATISTICS
+	// back buffer's counts are added to the front's (which counted shaping and glyph table preparation when the job started)
+	m_statistics.rebuildCount += back.m_statistics.rebuildCount;
+	m_statistics.lastRebuildTime = back.m_statistics.lastRebuildTime;
+	m_statistics.totalRebuildTime += back.m_statistics.totalRebuildTime;
+	m_statistics.glyphsEmitted = back.m_statistics.glyphsEmitted;
+	m_statistics.glyphLookups += back.m_statistics.glyphLookups;
+	m_statistics.kerningLookups += back.m_statistics.kerningLookups;
+	back.m_statistics = StatisticsCounters();
+#endif // SFMLTEXTALINE_ENABLE_STATISTICS
+
+	// alphas may have been changed while the layout was being calculated
+	if (!m_isUpdateRequired)
+	{
+		for (auto& characterAlpha : m_characterAlphas)
+			applyCharacterAlpha(characterAlpha.first, characterAlpha.second);
+	}
+	m_isVisibleRangeUpdateRequired = true;
+}
+
+void SfmlTextAline::prepareGlyphTable(GlyphTable& glyphTable, const sf::String& string) const
+{
+	glyphTable.lineSpacing = getLineSeparation();
+	glyphTable.glyphs.clear();
+	glyphTable.kernings.clear();
+	glyphTable.fontIndices.clear();
+
+	// visits characters as updateVertices does
+	std::size_t currentLine{ 0u };
+	std::uint32_t prevChar{ 0u };
+	std::size_t prevFontIndex{ 0u };
+	for (std::size_t i{ 0u }; i < string.getSize(); ++i)
+	{
+		const std::uint32_t currentChar{ string[i] };
+
+		const std::size_t fontIndex{ (m_fallbackFonts.empty() || isWhitespace(currentChar)) ? 0u : getFontIndex(currentChar) };
+		glyphTable.fontIndices.emplace(currentChar, fontIndex);
+
+		if (!m_isMonospace && (fontIndex == prevFontIndex))
+		{
+			if (auto [it, isInserted] { glyphTable.kernings.emplace(::getKerningKey(prevChar, currentChar), 0.f) }; isInserted)
+				it->second = getKerning(fontIndex, prevChar, currentChar);
+		}
+		prevChar = currentChar;
+		prevFontIndex = fontIndex;
+
+		const bool bold{ getLineBold(currentLine) };
+		if (auto [it, isInserted] { glyphTable.glyphs.emplace(::getGlyphKey(' ', bold), sf::Glyph()) }; isInserted)
+			it->second = getGlyph(0u, ' ', bold);
+		if (m_isTableLayout)
+		{
+			// column gap
+			if (auto [it, isInserted] { glyphTable.glyphs.emplace(::getGlyphKey(' ', false), sf::Glyph()) }; isInserted)
+				it->second = getGlyph(0u, ' ', false);
+		}
+
+		if (currentChar == '\n')
+			++currentLine;
+		if (isWhitespace(currentChar))
+			continue;
+
+		if (auto [it, isInserted] { glyphTable.glyphs.emplace(::getGlyphKey(currentChar, bold), sf::Glyph()) }; isInserted)
+			it->second = getGlyph(fontIndex, currentChar, bold);
+	}
+}
+
+const sf::Glyph& SfmlTextAline::getGlyph(const std::size_t fontIndex, const std::uint32_t character, const bool bold) const
+{
+	STATISTICS_ONLY(++m_statistics.glyphLookups);
+	if (m_glyphTable != nullptr)
+		return m_glyphTable->glyphs.at(::getGlyphKey(character, bold));
+	return getFontByIndex(fontIndex).getGlyph(character, static_cast<unsigned int>(m_characterSize), bold);
+}
+
+float SfmlTextAline::getKerning(const std::size_t fontIndex, const std::uint32_t first, const std::uint32_t second) const
+{
+	STATISTICS_ONLY(++m_statistics.kerningLookups);
+	if (m_glyphTable != nullptr)
+		return m_glyphTable->kernings.at(::getKerningKey(first, second));
+	return getFontByIndex(fontIndex).getKerning(first, second, static_cast<unsigned int>(m_characterSize));
+}
+
+SfmlTextAline::LayoutKey SfmlTextAline::createLayoutKey(const sf::String& string) const
+{
+	LayoutKey key;
+	key.string = string;
+	key.font = m_font;
+	key.fallbackFonts = m_fallbackFonts;
+	key.characterSize = m_characterSize;
+	key.color = m_color;
+	key.tabLength = m_tabLength;
+	key.globalAlignment = m_globalAlignment;
+	key.minWidth = m_minWidth;
+	key.textStyle = m_textStyle;
+	key.italicShear = m_italicShear;
+	key.lineHeightMultiplier = m_lineHeightMultiplier;
+	key.letterSpacingMultiplier = m_letterSpacingMultiplier;
+	key.isRoundingApplied = m_isRoundingApplied;
+	key.isMonospace = m_isMonospace;
+	key.isTableLayout = m_isTableLayout;
+	key.columnAlignments = m_columnAlignments;
+	key.columnDecimalPoints = m_columnDecimalPoints;
+	key.lineAlignments = m_lineAlignments;
+	key.lineOffsets = m_lineOffsets;
+	key.lineColors = m_lineColors;
+	key.lineBolds = m_lineBolds;
+	key.lineItalics = m_lineItalics;
+	return key;
+}
+
+void SfmlTextAline::setLayoutSettings(LayoutKey&& settings)
+{
+	m_string = std::move(settings.string);
+	m_font = settings.font;
+	m_fallbackFonts = std::move(settings.fallbackFonts);
+	m_characterSize = settings.characterSize;
+	m_color = settings.color;
+	m_tabLength = settings.tabLength;
+	m_globalAlignment = settings.globalAlignment;
+	m_minWidth = settings.minWidth;
+	m_textStyle = settings.textStyle;
+	m_italicShear = settings.italicShear;
+	m_lineHeightMultiplier = settings.lineHeightMultiplier;
+	m_letterSpacingMultiplier = settings.letterSpacingMultiplier;
+	m_isRoundingApplied = settings.isRoundingApplied;
+	m_isMonospace = settings.isMonospace;
+	m_isTableLayout = settings.isTableLayout;
+	m_columnAlignments = std::move(settings.columnAlignments);
+	m_columnDecimalPoints = std::move(settings.columnDecimalPoints);
+	m_lineAlignments = std::move(settings.lineAlignments);
+	m_lineOffsets = std::move(settings.lineOffsets);
+	m_lineColors = std::move(settings.lineColors);
+	m_lineBolds = std::move(settings.lineBolds);
+	m_lineItalics = std::move(settings.lineItalics);
+	m_isUpdateRequired = true;
+}
+
+bool SfmlTextAline::useSharedLayout(const LayoutKey& key) const
+{
+	SharedLayoutCache& cache{ getSharedLayoutCache() };
+	const std::lock_guard<std::mutex> lock(cache.mutex);
+
+	auto [it, end] { cache.layouts.equal_range(key.getHash()) };
+	while (it != end)
+	{
+		std::shared_ptr<const SharedLayout> sharedLayout{ it->second.lock() };
+		if (!sharedLayout)
+		{
+			it = cache.layouts.erase(it);
+			continue;
+		}
+		if (sharedLayout->key == key)
+		{
+			m_sharedLayout = std::move(sharedLayout);
+			m_localBounds = m_sharedLayout->localBounds;
+			m_atlas = m_sharedLayout->atlas;
+			m_isAtlasUsed = m_sharedLayout->isAtlasUsed;
+			m_isFallbackFontUsed = m_sharedLayout->isAtlasUsed; // layouts are only shared if they do not need separate draws per font
+
+			// own geometry is not needed while shared
+			std::vector<sf::Vertex>().swap(m_vertices);
+			std::vector<Line>().swap(m_lines);
+			return true;
+		}
+		++it;
+	}
+	return false;
+}
+
+void SfmlTextAline::shareLayout(LayoutKey&& key) const
+{
+	auto sharedLayout{ std::make_shared<SharedLayout>() };
+	sharedLayout->key = std::move(key);
+	sharedLayout->vertices = std::move(m_vertices);
+	sharedLayout->lines = std::move(m_lines);
+	sharedLayout->localBounds = m_localBounds;
+	sharedLayout->atlas = m_atlas;
+	sharedLayout->isAtlasUsed = m_isAtlasUsed;
+	m_vertices.clear();
+	m_lines.clear();
+
+	SharedLayoutCache& cache{ getSharedLayoutCache() };
+	const std::lock_guard<std::mutex> lock(cache.mutex);
+
+	// remove expired layouts occasionally
+	if (cache.layouts.size() >= cache.sweepSize)
+	{
+		for (auto it{ cache.layouts.begin() }; it != cache.layouts.end();)
+		{
+			if (it->second.expired())
+				it = cache.layouts.erase(it);
+			else
+				++it;
+		}
+		cache.sweepSize = std::max(minimumSharedLayoutSweepSize, cache.layouts.size() * 2u);
+	}
+
+	cache.layouts.emplace(sharedLayout->key.getHash(), sharedLayout);
+	m_sharedLayout = std::move(sharedLayout);
+}
+
+const std::vector<sf::Vertex>& SfmlTextAline::getCurrentVertices() const
+{
+	return m_sharedLayout ? m_sharedLayout->vertices : m_vertices;
+}
+
+const std::vector<SfmlTextAline::Line>& SfmlTextAline::getCurrentLines() const
+{
+	return m_sharedLayout ? m_sharedLayout->lines : m_lines;
+}
+
+SfmlTextAline::SharedLayoutCache& SfmlTextAline::getSharedLayoutCache()
+{
+	static SharedLayoutCache cache{ {}, {}, minimumSharedLayoutSweepSize };
+	return cache;
+}
+
+void SfmlTextAline::updateSourceString()
+{
+	const sf::String string{ m_source->decode(m_sourceFirstLine, m_sourceNumberOfLines) };
+	SET_AND_UPDATE_MEMBER_IF_DIFFERENT(string);
+}
+
+void SfmlTextAline::updateShapedString() const
+{
+	m_shapedString.clear();
+
+	// each line is a separate run
+	const std::size_t numberOfCharacters{ m_string.getSize() };
+	std::size_t runStart{ 0u };
+	std::size_t lineIndex{ 0u };
+	for (std::size_t i{ 0u }; i <= numberOfCharacters; ++i)
+	{
+		if ((i < numberOfCharacters) && (m_string[i] != '\n'))
+			continue;
+
+		if (i > runStart)
+		{
+			sf::Uint32 textStyle{ m_textStyle & ~static_cast<sf::Uint32>(sf::Text::Style::Bold | sf::Text::Style::Italic) };
+			if (getLineBold(lineIndex))
+				textStyle |= sf::Text::Style::Bold;
+			if (getLineItalic(lineIndex))
+				textStyle |= sf::Text::Style::Italic;
+			appendShapedRun({ m_string.substring(runStart, i - runStart), m_font, m_characterSize, textStyle });
+		}
+		if (i < numberOfCharacters)
+			m_shapedString += '\n';
+
+		runStart = i + 1u;
+		++lineIndex;
+	}
+}
+
+void SfmlTextAline::appendShapedRun(const ShapingCacheKey& key) const
+{
+	if (auto it{ m_shapingCache.positions.find(key) }; it != m_shapingCache.positions.end())
+	{
+		STATISTICS_ONLY(++m_statistics.shapingCacheHits);
+		m_shapingCache.runs.splice(m_shapingCache.runs.begin(), m_shapingCache.runs, it->second); // now most recently used
+		m_shapedString += it->second->shaped;
+		return;
+	}
+
+	STATISTICS_ONLY(++m_statistics.shapingCacheMisses);
+	const sf::String shaped{ m_shaper(key.run, *key.font, key.characterSize, key.textStyle) };
+	m_shapedString += shaped;
+
+	if (m_shapingCacheCapacity == 0u)
+		return;
+
+	// evict least recently used run
+	if (m_shapingCache.runs.size() >= m_shapingCacheCapacity)
+	{
+		m_shapingCache.positions.erase(m_shapingCache.runs.back().key);
+		m_shapingCache.runs.pop_back();
+	}
+
+	m_shapingCache.runs.push_front({ key, shaped });
+	m_shapingCache.positions.emplace(m_shapingCache.runs.front().key, m_shapingCache.runs.begin());
+}
+
+const sf::String& SfmlTextAline::getLayoutString() const
+{
+	return m_shaper ? m_shapedString : m_string;
+}
+
+bool SfmlTextAline::ShapingCacheKey::operator==(const ShapingCacheKey& other) const
+{
+	return (font == other.font) && (characterSize == other.characterSize) && (textStyle == other.textStyle) && (run == other.run);
+}
+
+std::size_t SfmlTextAline::ShapingCacheKeyHash::operator()(const ShapingCacheKey& key) const
+{
+	std::size_t hash{ std::hash<const sf::Font*>{}(key.font) };
+	::combineHash(hash, key.characterSize);
+	::combineHash(hash, key.textStyle);
+	for (std::size_t i{ 0u }; i < key.run.getSize(); ++i)
+		::combineHash(hash, key.run[i]);
+	return hash;
+}
+
+bool SfmlTextAline::ShapingCacheKeyEqual::operator()(const ShapingCacheKey& a, const ShapingCacheKey& b) const
+{
+	return a == b;
+}
+
+SfmlTextAline::ShapingCache::ShapingCache()
+	: runs()
+	, positions()
+{
+}
+
+SfmlTextAline::ShapingCache::ShapingCache(const ShapingCache& shapingCache)
+	: ShapingCache()
+{
+	*this = shapingCache;
+}
+
+SfmlTextAline::ShapingCache& SfmlTextAline::ShapingCache::operator=(const ShapingCache& shapingCache)
+{
+	if (this == &shapingCache)
+		return *this;
+
+	runs = shapingCache.runs;
+	positions.clear();
+	for (auto it{ runs.begin() }; it != runs.end(); ++it)
+		positions.emplace(it->key, it);
+	return *this;
+}
+
+void SfmlTextAline::ShapingCache::clear()
+{
+	positions.clear();
+	runs.clear();
+}
+
+SfmlTextAline::AsyncLayout::AsyncLayout()
+	: back()
+	, glyphTable()
+	, job()
+	, isCopiedWhilePending{ false }
+{
+}
+
+SfmlTextAline::AsyncLayout::AsyncLayout(const AsyncLayout& asyncLayout)
+	: AsyncLayout()
+{
+	isCopiedWhilePending = asyncLayout.job.valid() || asyncLayout.isCopiedWhilePending;
+}
+
+SfmlTextAline::AsyncLayout& SfmlTextAline::AsyncLayout::operator=(const AsyncLayout& asyncLayout)
+{
+	// keeps its own back buffer; any job in progress is for settings that are being replaced so is discarded
+	const bool isSourcePending{ asyncLayout.job.valid() || asyncLayout.isCopiedWhilePending };
+	if (job.valid())
+		job.wait();
+	job = std::shared_future<void>();
+	isCopiedWhilePending = isSourcePending;
+	return *this;
+}
+
+SfmlTextAline::AsyncLayout::~AsyncLayout()
+{
+	// the job uses the back buffer so it must finish first
+	if (job.valid())
+		job.wait();
+}
+
+bool SfmlTextAline::LayoutKey::operator==(const LayoutKey& other) const
+{
+	return (font == other.font)
+		&& (characterSize == other.characterSize)
+		&& (color == other.color)
+		&& (tabLength == other.tabLength)
+		&& (globalAlignment == other.globalAlignment)
+		&& (minWidth == other.minWidth)
+		&& (textStyle == other.textStyle)
+		&& (italicShear == other.italicShear)
+		&& (lineHeightMultiplier == other.lineHeightMultiplier)
+		&& (letterSpacingMultiplier == other.letterSpacingMultiplier)
+		&& (isRoundingApplied == other.isRoundingApplied)
+		&& (isMonospace == other.isMonospace)
+		&& (isTableLayout == other.isTableLayout)
+		&& (columnAlignments == other.columnAlignments)
+		&& (columnDecimalPoints == other.columnDecimalPoints)
+		&& (fallbackFonts == other.fallbackFonts)
+		&& (lineAlignments == other.lineAlignments)
+		&& (lineOffsets == other.lineOffsets)
+		&& (lineColors == other.lineColors)
+		&& (lineBolds == other.lineBolds)
+		&& (lineItalics == other.lineItalics)
+		&& (string == other.string);
+}
+
+std::size_t SfmlTextAline::LayoutKey::getHash() const
+{
+	std::size_t hash{ std::hash<const sf::Font*>{}(font) };
+	for (auto& fallbackFont : fallbackFonts)
+		::combineHash(hash, std::hash<const sf::Font*>{}(fallbackFont));
+	::combineHash(hash, characterSize);
+	::combineHash(hash, ::getColorHash(color));
+	::combineHash(hash, tabLength);
+	::combineHash(hash, static_cast<std::size_t>(globalAlignment));
+	::combineHash(hash, std::hash<float>{}(minWidth));
+	::combineHash(hash, textStyle);
+	::combineHash(hash, std::hash<float>{}(italicShear));
+	::combineHash(hash, std::hash<float>{}(lineHeightMultiplier));
+	::combineHash(hash, std::hash<float>{}(letterSpacingMultiplier));
+	::combineHash(hash, (isRoundingApplied ? 1u : 0u) | (isMonospace ? 2u : 0u) | (isTableLayout ? 4u : 0u));
+	::combineHash(hash, ::getMapHash(columnAlignments, [](const Alignment alignment) { return static_cast<std::size_t>(alignment); }));
+	::combineHash(hash, ::getMapHash(columnDecimalPoints, [](const std::uint32_t decimalPoint) { return static_cast<std::size_t>(decimalPoint); }));
+	::combineHash(hash, ::getMapHash(lineAlignments, [](const Alignment alignment) { return static_cast<std::size_t>(alignment); }));
+	::combineHash(hash, ::getMapHash(lineOffsets, [](const sf::Vector2f offset) { std::size_t offsetHash{ std::hash<float>{}(offset.x) }; ::combineHash(offsetHash, std::hash<float>{}(offset.y)); return offsetHash; }));
+	::combineHash(hash, ::getMapHash(lineColors, ::getColorHash));
+	::combineHash(hash, ::getMapHash(lineBolds, [](const bool bold) { return static_cast<std::size_t>(bold); }));
+	::combineHash(hash, ::getMapHash(lineItalics, [](const bool italic) { return static_cast<std::size_t>(italic); }));
+	for (std::size_t i{ 0u }; i < string.getSize(); ++i)
+		::combineHash(hash, string[i]);
+	return hash;
 }
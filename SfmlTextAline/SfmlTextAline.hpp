@@ -39,10 +39,19 @@
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/RenderStates.hpp>
 #include <SFML/Graphics/Text.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/RenderTexture.hpp>
+#include <SFML/System/Time.hpp>
 
 #include <vector>
+#include <list>
 #include <string>
 #include <unordered_map>
+#include <functional>
+#include <memory>
+#include <future>
+#include <cstdint>
+#include <mutex>
 
 // SfmlTextAline v0.4.0 (WIP)
 class SfmlTextAline : public sf::Drawable, public sf::Transformable
@@ -62,9 +71,19 @@ public:
         JustifyCharacters,
     };
 
+    // a shaper converts a single line (run) of text into the codepoints to lay out (e.g. contextual forms and ligatures)
+    // it can be backed by a full shaping engine (such as HarfBuzz) as long as its result is expressed as codepoints available in the font
+    using Shaper = std::function<sf::String(const sf::String& run, const sf::Font& font, std::size_t characterSize, sf::Uint32 textStyle)>;
+
     void setFont(const sf::Font& font);
     void setFont();
+    void addFallbackFont(const sf::Font& font); // used (in order added) for characters missing from the main font
+    void removeFallbackFonts();
     void setString(const sf::String& string);
+    bool loadFromFile(const std::string& filename); // memory-maps a UTF-8 file; only the lines in the source line range (default: first 1000 lines) are decoded (into the string)
+    void setSourceLineRange(std::size_t firstLine, std::size_t numberOfLines);
+    void removeSourceLineRange(); // all lines; note that the whole file is then decoded (and laid out) so this should be avoided for large files
+    void removeSource(); // keeps current string
     void setCharacterSize(std::size_t characterSize);
     void setColor(sf::Color color);
     void setTabLength(std::size_t tabLength);
@@ -76,6 +95,26 @@ public:
     void setLineHeightMultiplier(float lineHeightMultiplier);
     void setLetterSpacingMultiplier(float letterSpacingMultiplier);
     void setIsRoundingApplied(bool isRoundingApplied);
+    void setIsMonospace(bool isMonospace); // when monospace, kerning is skipped, positions are calculated from columns and tabs move to the next tab stop (every tab length columns)
+    void setIsMonospace(); // detects from current font
+    void setShaper(const Shaper& shaper); // when shaped, character indices (visible range and alphas) refer to the shaped text
+    void setShaper(); // removes shaper
+    void setShapingCacheCapacity(std::size_t shapingCacheCapacity); // number of shaped runs remembered
+    void setIsLayoutAsync(bool isLayoutAsync); // when async, layout is calculated on a worker thread and the previous layout is drawn until it is ready
+    void setLayoutReadyCallback(const std::function<void()>& layoutReadyCallback); // called from the worker thread when an async layout is ready
+    std::shared_future<void> startLayout(); // starts an async layout if required (otherwise updates immediately); future is ready when the layout is
+    void setLayoutCharacterBudget(std::size_t layoutCharacterBudget); // when drawing, layout stops after this many characters and continues on the next draw (0 is no limit)
+    void setLayoutTimeBudget(sf::Time layoutTimeBudget); // when drawing, layout stops after this much time and continues on the next draw (zero is no limit)
+    void removeLayoutBudget();
+    void setIsLayoutShared(bool isLayoutShared); // when shared, objects with identical text and settings share one (read-only) layout; not shared while character alphas are set or layout is async
+    void setIsCached(bool isCached); // when cached, text is rendered once to a texture and drawn as a single quad; drawn directly if transformed (scaled, rotated etc.), while partially laid out, or with a shader or non-alpha blend mode
+
+    // table layout: tabs separate cells into columns that are as wide as their widest cell; line alignment moves the whole table (justification is not applied)
+    void setIsTableLayout(bool isTableLayout);
+    void setColumnAlignment(std::size_t columnIndex, Alignment alignment); // justified alignments are treated as left
+    void setColumnDecimalAlignment(std::size_t columnIndex, std::uint32_t decimalPoint = '.'); // aligns cells on their decimal point
+    void removeColumnAlignment(std::size_t columnIndex); // also removes decimal alignment
+    void removeColumnAlignments();
 
     void setLineAlignment(std::size_t lineIndex, Alignment alignment);
     void removeLineAlignment(std::size_t lineIndex);
@@ -94,10 +133,23 @@ public:
     void removeLineItalic(std::size_t lineIndex);
     void removeLineItalics();
 
+    // visibility only affects drawing; the entire text is still laid out (and included in bounds)
+    void setVisibleCharacterRange(std::size_t start, std::size_t length);
+    void setVisibleCharacterCount(std::size_t count); // visible range starts at the first character
+    void removeVisibleCharacterRange(); // all characters visible
+    void setCharacterAlpha(std::size_t characterIndex, sf::Uint8 alpha); // multiplies the character's (line's) colour's alpha
+    void removeCharacterAlpha(std::size_t characterIndex);
+    void removeCharacterAlphas();
+
     std::size_t getNumberOfLines() const;
     float getLineSeparation() const;
     const sf::Font* getFont() const;
+    std::size_t getNumberOfFallbackFonts() const;
+    const sf::Font* getFallbackFont(std::size_t fallbackIndex) const;
     sf::String getString() const;
+    std::size_t getNumberOfSourceLines() const;
+    std::size_t getSourceFirstLine() const;
+    std::size_t getSourceNumberOfLines() const;
     std::size_t getCharacterSize() const;
     sf::Color getColor() const;
     std::size_t getTabLength() const;
@@ -108,6 +160,19 @@ public:
     float getLineHeightMultiplier() const;
     float getLetterSpacingMultiplier() const;
     bool getIsRoundingApplied() const;
+    bool getIsMonospace() const;
+    bool getIsShaped() const;
+    std::size_t getShapingCacheCapacity() const;
+    bool getIsLayoutAsync() const;
+    bool getIsLayoutPending() const;
+    std::size_t getLayoutCharacterBudget() const;
+    sf::Time getLayoutTimeBudget() const;
+    bool getIsLayoutShared() const;
+    bool getIsCached() const;
+
+    bool getIsTableLayout() const;
+    Alignment getColumnAlignment(std::size_t columnIndex) const;
+    std::uint32_t getColumnDecimalPoint(std::size_t columnIndex) const; // zero if not decimal aligned
 
     Alignment getLineAlignment(std::size_t lineIndex) const;
     sf::Vector2f getLineOffset(std::size_t lineIndex) const;
@@ -115,12 +180,39 @@ public:
     bool getLineBold(std::size_t lineIndex) const;
     bool getLineItalic(std::size_t lineIndex) const;
 
+    std::size_t getVisibleCharacterStart() const;
+    std::size_t getVisibleCharacterLength() const;
+    sf::Uint8 getCharacterAlpha(std::size_t characterIndex) const;
+
     sf::FloatRect getLocalBounds() const;
     sf::FloatRect getGlobalBounds() const;
+    const std::vector<sf::Vertex>& getVertices() const; // laid-out geometry (triangles, local co-ordinates); e.g. for comparing layouts
 
+#ifdef SFMLTEXTALINE_ENABLE_STATISTICS
+    struct Statistics
+    {
+        std::size_t rebuildCount;
+        sf::Time lastRebuildTime;
+        sf::Time averageRebuildTime;
+        std::size_t glyphsEmitted; // quads created by the last rebuild
+        std::size_t glyphLookups; // sf::Font::getGlyph calls made by the last rebuild
+        std::size_t kerningLookups; // sf::Font::getKerning calls made by the last rebuild
+        std::size_t shapingCacheHits; // runs found in the shaping cache by the last rebuild
+        std::size_t shapingCacheMisses; // runs shaped by the last rebuild
+        std::size_t verticesResident;
+        std::size_t bytesAllocated; // capacity of layout buffers (including a used shared layout and the async back buffer), shaping cache and textures (4 bytes per pixel of the atlas and render cache); shared storage is counted by every object using it
+        const char* lastInvalidation; // name of the method that last required an update
+    };
+    Statistics getStatistics() const;
+    void resetStatistics();
+#endif // SFMLTEXTALINE_ENABLE_STATISTICS
 
 
 private:
+#ifdef SFMLTEXTALINE_ENABLE_TESTS
+    friend class SfmlTextAlineTests; // tests (see tests folder) compare lines and drive progressive layout directly
+#endif // SFMLTEXTALINE_ENABLE_TESTS
+
     const sf::Font* m_font;
     sf::String m_string;
     std::size_t m_characterSize;
@@ -133,12 +225,16 @@ private:
     float m_lineHeightMultiplier;
     float m_letterSpacingMultiplier;
     bool m_isRoundingApplied;
+    bool m_isMonospace;
+    bool m_isTableLayout;
 
     std::unordered_map<std::size_t, Alignment> m_lineAlignments;
     std::unordered_map<std::size_t, sf::Vector2f> m_lineOffsets;
     std::unordered_map<std::size_t, sf::Color> m_lineColors;
     std::unordered_map<std::size_t, bool> m_lineBolds;
     std::unordered_map<std::size_t, bool> m_lineItalics;
+    std::unordered_map<std::size_t, Alignment> m_columnAlignments;
+    std::unordered_map<std::size_t, std::uint32_t> m_columnDecimalPoints;
 
     struct Line
     {
@@ -152,13 +248,246 @@ private:
         sf::Color color;
     };
 
+    struct TableCell
+    {
+        std::size_t line;
+        std::size_t column;
+        std::size_t firstQuad;
+        std::size_t numberOfQuads;
+        float width;
+        float decimalPosition; // negative if no decimal point
+    };
+
+    struct Source; // memory-mapped file and its line index
+    std::shared_ptr<const Source> m_source;
+    std::size_t m_sourceFirstLine;
+    std::size_t m_sourceNumberOfLines;
+
+    std::size_t m_visibleCharacterStart;
+    std::size_t m_visibleCharacterLength;
+    std::unordered_map<std::size_t, sf::Uint8> m_characterAlphas;
+
+    struct ShapingCacheKey
+    {
+        sf::String run;
+        const sf::Font* font;
+        std::size_t characterSize;
+        sf::Uint32 textStyle;
+
+        bool operator==(const ShapingCacheKey& other) const;
+    };
+    struct ShapingCacheKeyHash
+    {
+        std::size_t operator()(const ShapingCacheKey& key) const;
+    };
+    struct ShapingCacheKeyEqual
+    {
+        bool operator()(const ShapingCacheKey& a, const ShapingCacheKey& b) const;
+    };
+    struct ShapedRun
+    {
+        ShapingCacheKey key;
+        sf::String shaped;
+    };
+    // runs in order of use and indexed by key so that finding, refreshing and evicting a run take constant time
+    struct ShapingCache
+    {
+        std::list<ShapedRun> runs; // most recently used first
+        std::unordered_map<std::reference_wrapper<const ShapingCacheKey>, std::list<ShapedRun>::iterator, ShapingCacheKeyHash, ShapingCacheKeyEqual> positions; // keys refer to the runs' keys
+
+        ShapingCache();
+        ShapingCache(const ShapingCache& shapingCache); // positions are rebuilt to refer to the copied runs
+        ShapingCache& operator=(const ShapingCache& shapingCache);
+        void clear();
+    };
+
+    std::vector<const sf::Font*> m_fallbackFonts;
+    mutable std::unordered_map<std::uint32_t, std::size_t> m_fontIndices; // font index (0 is main font; others are fallback index + 1) of each character used so far
+
+    Shaper m_shaper;
+    std::size_t m_shapingCacheCapacity;
+    mutable ShapingCache m_shapingCache;
+    mutable sf::String m_shapedString;
+
+    // read-only copy of every glyph, kerning and font choice needed for a layout so that it can be calculated without using the fonts
+    struct GlyphTable
+    {
+        float lineSpacing;
+        std::unordered_map<std::uint64_t, sf::Glyph> glyphs; // key: character and bold
+        std::unordered_map<std::uint64_t, float> kernings; // key: both characters
+        std::unordered_map<std::uint32_t, std::size_t> fontIndices;
+    };
+    struct AsyncLayout
+    {
+        std::unique_ptr<SfmlTextAline> back; // back buffer; only given the layout settings (not copied from the front)
+        GlyphTable glyphTable;
+        std::shared_future<void> job;
+        bool isCopiedWhilePending; // copy has the previous layout and no job so must lay out again
+
+        AsyncLayout();
+        AsyncLayout(const AsyncLayout&); // copies are not given the job
+        AsyncLayout& operator=(const AsyncLayout&);
+        ~AsyncLayout();
+    };
+
+    bool m_isLayoutAsync;
+    std::function<void()> m_layoutReadyCallback;
+    mutable AsyncLayout m_asyncLayout;
+    const GlyphTable* m_glyphTable; // only set for the snapshot of an async layout
+
+    // everything that affects a layout (also used to pass the settings to the async back buffer)
+    struct LayoutKey
+    {
+        sf::String string; // after shaping
+        const sf::Font* font;
+        std::vector<const sf::Font*> fallbackFonts;
+        std::size_t characterSize;
+        sf::Color color;
+        std::size_t tabLength;
+        Alignment globalAlignment;
+        float minWidth;
+        sf::Uint32 textStyle;
+        float italicShear;
+        float lineHeightMultiplier;
+        float letterSpacingMultiplier;
+        bool isRoundingApplied;
+        bool isMonospace;
+        bool isTableLayout;
+        std::unordered_map<std::size_t, Alignment> columnAlignments;
+        std::unordered_map<std::size_t, std::uint32_t> columnDecimalPoints;
+        std::unordered_map<std::size_t, Alignment> lineAlignments;
+        std::unordered_map<std::size_t, sf::Vector2f> lineOffsets;
+        std::unordered_map<std::size_t, sf::Color> lineColors;
+        std::unordered_map<std::size_t, bool> lineBolds;
+        std::unordered_map<std::size_t, bool> lineItalics;
+
+        bool operator==(const LayoutKey& other) const;
+        std::size_t getHash() const;
+    };
+    struct Atlas; // glyphs of all used fonts packed into one texture
+    struct SharedLayout
+    {
+        LayoutKey key;
+        std::vector<sf::Vertex> vertices;
+        std::vector<Line> lines;
+        sf::FloatRect localBounds;
+        std::shared_ptr<Atlas> atlas;
+        bool isAtlasUsed;
+    };
+    struct SharedLayoutCache
+    {
+        std::mutex mutex;
+        std::unordered_multimap<std::size_t, std::weak_ptr<const SharedLayout>> layouts; // key: hash of layout key
+        std::size_t sweepSize; // expired layouts are removed when the cache reaches this size
+    };
+
+    bool m_isLayoutShared;
+    mutable std::shared_ptr<const SharedLayout> m_sharedLayout;
+
+    // state of a progressive layout so that it can continue
+    struct LayoutCursor
+    {
+        bool isInProgress{ false };
+        std::size_t characterIndex{ 0u };
+        std::size_t currentQuad{ 0u };
+        std::size_t numberOfUnusedQuads{ 0u };
+        sf::Vector2f position{ 0.f, 0.f };
+        std::size_t currentLine{ 0u };
+        float lineWidth{ 0.f };
+        std::size_t lineStartIndex{ 0u };
+        std::size_t lineStartQuad{ 0u };
+        std::uint32_t prevChar{ 0u };
+        std::size_t prevFontIndex{ 0u };
+        std::size_t column{ 0u };
+        std::size_t cellColumn{ 0u };
+        std::size_t cellFirstQuad{ 0u };
+        float cellDecimalPosition{ -1.f };
+        std::size_t numberOfColoredLines{ 0u };
+    };
+
+    std::size_t m_layoutCharacterBudget;
+    sf::Time m_layoutTimeBudget;
+    mutable LayoutCursor m_layoutCursor;
+
     mutable sf::FloatRect m_localBounds;
     mutable bool m_isUpdateRequired;
     mutable std::vector<sf::Vertex> m_vertices;
     mutable std::vector<Line> m_lines;
+    mutable std::vector<std::size_t> m_quadFontIndices;
+    mutable std::vector<TableCell> m_tableCells;
+    mutable std::shared_ptr<Atlas> m_atlas; // only used when a fallback font is used; kept (and shared by copies) so that each glyph is only copied into it once
+    mutable bool m_isAtlasUsed;
+    mutable bool m_isFallbackFontUsed; // if atlas is not used, each font's glyphs are drawn separately
+
+    // fonts and string that the vertices were laid out with; they are drawn and patched using these (an async layout's settings can change before its vertices are swapped in)
+    struct LaidOut
+    {
+        const sf::Font* font{ nullptr };
+        std::vector<const sf::Font*> fallbackFonts;
+        std::size_t characterSize{ 0u };
+        sf::String string; // after shaping
+    };
+    mutable LaidOut m_laidOut;
+
+    bool m_isCached;
+    mutable std::shared_ptr<sf::RenderTexture> m_cache; // shared by copies until one of them needs to render
+    mutable std::vector<sf::Vertex> m_cacheVertices; // empty if cache cannot be used
+    mutable bool m_isCacheUpdateRequired;
+    mutable bool m_isVisibleRangeUpdateRequired;
+    mutable std::size_t m_visibleVertexStart;
+    mutable std::size_t m_visibleVertexCount;
+    mutable std::vector<std::size_t> m_characterQuadIndices; // number of quads before each character (and after the last); built when first needed after a layout
+
+#ifdef SFMLTEXTALINE_ENABLE_STATISTICS
+    struct StatisticsCounters
+    {
+        std::size_t rebuildCount{ 0u };
+        sf::Time lastRebuildTime{ sf::Time::Zero };
+        sf::Time totalRebuildTime{ sf::Time::Zero };
+        std::size_t glyphsEmitted{ 0u };
+        std::size_t glyphLookups{ 0u };
+        std::size_t kerningLookups{ 0u };
+        std::size_t shapingCacheHits{ 0u };
+        std::size_t shapingCacheMisses{ 0u };
+        sf::Time progressiveLayoutTime{ sf::Time::Zero }; // time of a progressive layout's previous parts
+        const char* lastInvalidation{ "" };
+    };
+    mutable StatisticsCounters m_statistics;
+
+    std::size_t getBytesAllocated() const;
+#endif // SFMLTEXTALINE_ENABLE_STATISTICS
 
     virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const;
-    void updateVertices() const;
+    void drawVertices(sf::RenderTarget& target, sf::RenderStates states, std::size_t vertexStart, std::size_t numberOfVertices) const;
+    void updateVertices(bool isWithinBudget = false) const;
+    void updateIfRequired(bool isWithinBudget = false) const;
+    void updateAsyncLayout() const;
+    void flagUpdateIfCopiedWhilePending() const;
+    void startAsyncLayout() const;
+    void finishAsyncLayout() const;
+    void prepareGlyphTable(GlyphTable& glyphTable, const sf::String& string) const;
+    const sf::Glyph& getGlyph(std::size_t fontIndex, std::uint32_t character, bool bold) const;
+    float getKerning(std::size_t fontIndex, std::uint32_t first, std::uint32_t second) const;
+    LayoutKey createLayoutKey(const sf::String& string) const;
+    void setLayoutSettings(LayoutKey&& settings);
+    bool useSharedLayout(const LayoutKey& key) const;
+    void shareLayout(LayoutKey&& key) const;
+    const std::vector<sf::Vertex>& getCurrentVertices() const;
+    const std::vector<Line>& getCurrentLines() const;
+    static SharedLayoutCache& getSharedLayoutCache();
+    void updateVisibleRange() const;
+    void updateAtlas() const;
+    void updateCache() const;
+    bool getIsCacheDrawable(const sf::RenderStates& states) const;
+    void updateTableLayout() const;
+    std::size_t getFontIndex(std::uint32_t character) const;
+    const sf::Font& getFontByIndex(std::size_t fontIndex) const;
+    void updateShapedString() const;
+    void updateSourceString();
+    void appendShapedRun(const ShapingCacheKey& key) const;
+    const sf::String& getLayoutString() const;
+    void applyCharacterAlpha(std::size_t characterIndex, sf::Uint8 alpha) const;
+    std::size_t getCharacterQuadIndex(std::size_t characterIndex) const;
 
 };
 
@@ -0,0 +1,896 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// SFML Text "Aline" (https://github.com/Hapaxia/SfmlTextAline)
+//
+// Copyright(c) 2023-2024 M.J.Silk
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions :
+//
+// 1. The origin of this software must not be misrepresented; you must not
+// claim that you wrote the original software.If you use this software
+// in a product, an acknowledgment in the product documentation would be
+// appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+// misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+// M.J.Silk
+// MJSilk2@gmail.com
+//
+//////////////////////////////////////////////////////////////////////////////
+
+// usage: SfmlTextAlineTests <structure|golden|text|modes|fuzz> [--update-golden]
+//
+// structure: lines (without widths) and quad colours of fixed cases compared to stored output (structure.golden); these do not depend on font metrics
+// golden:    layouts (vertices, lines and bounds) of fixed cases compared to stored output (layouts.golden)
+// text:   glyph quads compared to sf::Text's character positions
+// modes:  progressive, async and shared layouts of the fixed cases compared to immediate layouts
+// fuzz:   seeded random strings and settings compared through all modes; monospace and table columns checked
+//
+// fonts are bundled (fonts folder) so results do not depend on the system's fonts;
+// texture co-ordinates depend on SFML's glyph packing so golden output must be created with the SFML version being tested (structure output does not)
+
+#include "SfmlTextAline/SfmlTextAline.hpp"
+
+#include <SFML/Graphics/Text.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class SfmlTextAlineTests
+{
+public:
+	static const auto& getLines(const SfmlTextAline& sfmlTextAline)
+	{
+		return sfmlTextAline.getCurrentLines();
+	}
+
+	static void updateWithinBudget(const SfmlTextAline& sfmlTextAline)
+	{
+		sfmlTextAline.updateIfRequired(true);
+	}
+
+	static bool getIsLayoutInProgress(const SfmlTextAline& sfmlTextAline)
+	{
+		return sfmlTextAline.m_layoutCursor.isInProgress;
+	}
+};
+
+namespace
+{
+
+constexpr int exitPassed{ 0 };
+constexpr int exitFailed{ 1 };
+constexpr int exitSkipped{ 77 }; // CTest's SKIP_RETURN_CODE
+constexpr unsigned int fuzzSeed{ 20240611u };
+constexpr std::size_t fuzzIterations{ 400u };
+constexpr float positionTolerance{ 0.001f };
+
+struct Fonts
+{
+	sf::Font sans;
+	sf::Font mono;
+};
+
+using SetUp = std::function<void(SfmlTextAline&)>;
+
+struct Case
+{
+	std::string name;
+	SetUp setUp;
+};
+
+enum class Mode
+{
+	Immediate,
+	Progressive,
+	Async,
+	AsyncAfterProgressive,
+	Shared,
+};
+
+std::string getFilename(const std::string& relativePath)
+{
+	return std::string(SFMLTEXTALINE_TESTS_DIRECTORY) + "/" + relativePath;
+}
+
+bool loadFonts(Fonts& fonts)
+{
+	return fonts.sans.loadFromFile(getFilename("fonts/DejaVuSans.ttf")) && fonts.mono.loadFromFile(getFilename("fonts/DejaVuSansMono.ttf"));
+}
+
+bool isWhitespace(const std::uint32_t character)
+{
+	return (character == ' ') || (character == '\t') || (character == '\n');
+}
+
+sf::String toSfmlString(const std::u32string& string)
+{
+	sf::String sfmlString;
+	for (const char32_t character : string)
+		sfmlString += sf::String(static_cast<sf::Uint32>(character));
+	return sfmlString;
+}
+
+std::string escape(const sf::String& string)
+{
+	std::ostringstream out;
+	for (const sf::Uint32 character : string)
+	{
+		if (character == '\n')
+			out << "\\n";
+		else if (character == '\t')
+			out << "\\t";
+		else if ((character < 0x20u) || (character > 0x7Eu))
+			out << "\\u{" << std::hex << character << std::dec << "}";
+		else
+			out << static_cast<char>(character);
+	}
+	return out.str();
+}
+
+void writeColor(std::ostream& out, const sf::Color color)
+{
+	out << static_cast<int>(color.r) << ' ' << static_cast<int>(color.g) << ' ' << static_cast<int>(color.b) << ' ' << static_cast<int>(color.a);
+}
+
+// complete layout as text: bounds, lines and vertices (positions, texture co-ordinates and colours)
+std::string describeLayout(const SfmlTextAline& sfmlTextAline)
+{
+	const std::vector<sf::Vertex>& vertices{ sfmlTextAline.getVertices() };
+	const sf::FloatRect bounds{ sfmlTextAline.getLocalBounds() };
+
+	std::ostringstream out;
+	out << std::setprecision(9);
+	out << "bounds " << bounds.left << ' ' << bounds.top << ' ' << bounds.width << ' ' << bounds.height << '\n';
+	const auto& lines{ SfmlTextAlineTests::getLines(sfmlTextAline) };
+	out << "lines " << lines.size() << '\n';
+	for (auto& line : lines)
+	{
+		out << line.start << ' ' << line.length << ' ' << line.vertexIndex << ' ' << line.numberOfQuads << ' ' << line.width << ' ' << static_cast<int>(line.alignment) << ' ' << line.offset.x << ' ' << line.offset.y << ' ';
+		writeColor(out, line.color);
+		out << '\n';
+	}
+	out << "vertices " << vertices.size() << '\n';
+	for (auto& vertex : vertices)
+	{
+		out << vertex.position.x << ' ' << vertex.position.y << ' ' << vertex.texCoords.x << ' ' << vertex.texCoords.y << ' ';
+		writeColor(out, vertex.color);
+		out << '\n';
+	}
+	return out.str();
+}
+
+// layout without anything that depends on font metrics or glyph packing: lines (without widths) and quad colours
+std::string describeStructure(const SfmlTextAline& sfmlTextAline)
+{
+	const std::vector<sf::Vertex>& vertices{ sfmlTextAline.getVertices() };
+
+	std::ostringstream out;
+	out << std::setprecision(9);
+	const auto& lines{ SfmlTextAlineTests::getLines(sfmlTextAline) };
+	out << "lines " << lines.size() << '\n';
+	for (auto& line : lines)
+	{
+		out << line.start << ' ' << line.length << ' ' << line.vertexIndex << ' ' << line.numberOfQuads << ' ' << static_cast<int>(line.alignment) << ' ' << line.offset.x << ' ' << line.offset.y << ' ';
+		writeColor(out, line.color);
+		out << '\n';
+	}
+	out << "quads " << (vertices.size() / 6u) << '\n';
+	for (std::size_t v{ 0u }; v < vertices.size();)
+	{
+		// runs of quads with the same colour
+		std::size_t end{ v + 6u };
+		while ((end < vertices.size()) && (vertices[end].color == vertices[v].color))
+			end += 6u;
+		out << ((end - v) / 6u) << " x ";
+		writeColor(out, vertices[v].color);
+		out << '\n';
+		v = end;
+	}
+	return out.str();
+}
+
+// layout of a freshly set up object using the given mode (mode settings are removed before describing so only the layout differs)
+std::string layOut(const SetUp& setUp, const Mode mode, const std::size_t layoutCharacterBudget = 7u)
+{
+	SfmlTextAline sfmlTextAline;
+	setUp(sfmlTextAline);
+
+	switch (mode)
+	{
+	case Mode::Progressive:
+	{
+		sfmlTextAline.setLayoutCharacterBudget(layoutCharacterBudget);
+		const std::size_t maximumNumberOfSteps{ sfmlTextAline.getString().getSize() + 2u };
+		std::size_t numberOfSteps{ 0u };
+		while (sfmlTextAline.getIsLayoutPending())
+		{
+			if (++numberOfSteps > maximumNumberOfSteps)
+				return "progressive layout did not complete\n";
+			SfmlTextAlineTests::updateWithinBudget(sfmlTextAline);
+		}
+		if ((sfmlTextAline.getString().getSize() > layoutCharacterBudget) && (numberOfSteps < 2u))
+			return "layout was not progressive\n";
+		sfmlTextAline.removeLayoutBudget();
+		break;
+	}
+	case Mode::Async:
+	{
+		// replaces a previous layout; an alpha patched and a copy made while the job is pending must not affect either result
+		const sf::String string{ sfmlTextAline.getString() };
+		sfmlTextAline.setString("previous\nlayout");
+		sfmlTextAline.getVertices();
+		sfmlTextAline.setIsLayoutAsync(true);
+		sfmlTextAline.setString(string);
+		const std::shared_future<void> job{ sfmlTextAline.startLayout() };
+		sfmlTextAline.setCharacterAlpha(0u, 0u);
+		sfmlTextAline.removeCharacterAlpha(0u);
+		SfmlTextAline copy{ sfmlTextAline };
+		job.wait();
+		sfmlTextAline.getVertices(); // collects finished layout
+		sfmlTextAline.setIsLayoutAsync(false);
+		copy.setIsLayoutAsync(false);
+		if (describeLayout(copy) != describeLayout(sfmlTextAline))
+			return "copy made during async layout is different\n";
+		break;
+	}
+	case Mode::AsyncAfterProgressive:
+		// async layout takes over from a progressive layout that is in progress
+		sfmlTextAline.setLayoutCharacterBudget(layoutCharacterBudget);
+		SfmlTextAlineTests::updateWithinBudget(sfmlTextAline);
+		sfmlTextAline.setIsLayoutAsync(true);
+		sfmlTextAline.startLayout().wait();
+		sfmlTextAline.getVertices(); // collects finished layout
+		sfmlTextAline.setIsLayoutAsync(false);
+		sfmlTextAline.removeLayoutBudget();
+		if (SfmlTextAlineTests::getIsLayoutInProgress(sfmlTextAline))
+			return "progressive layout is still in progress after async layout\n";
+		break;
+	case Mode::Shared:
+	{
+		SfmlTextAline original;
+		setUp(original);
+		original.setIsLayoutShared(true);
+		sfmlTextAline.setIsLayoutShared(true);
+		if (!sfmlTextAline.getString().isEmpty() && (&original.getVertices() != &sfmlTextAline.getVertices()))
+			return "layout was not shared\n";
+		break;
+	}
+	case Mode::Immediate:
+	default:
+		break;
+	}
+
+	return describeLayout(sfmlTextAline);
+}
+
+// reports first different line; returns true if same
+bool compare(const std::string& expected, const std::string& actual, const std::string& description)
+{
+	if (expected == actual)
+		return true;
+
+	std::istringstream expectedLines(expected);
+	std::istringstream actualLines(actual);
+	std::string expectedLine;
+	std::string actualLine;
+	std::size_t lineNumber{ 1u };
+	while (true)
+	{
+		const bool isExpectedLine{ static_cast<bool>(std::getline(expectedLines, expectedLine)) };
+		const bool isActualLine{ static_cast<bool>(std::getline(actualLines, actualLine)) };
+		if (!isExpectedLine && !isActualLine)
+			break;
+		if (!isExpectedLine || !isActualLine || (expectedLine != actualLine))
+		{
+			std::cerr << "FAILED: " << description << " (line " << lineNumber << ")\n"
+				<< "  expected: " << (isExpectedLine ? expectedLine : "<end>") << "\n"
+				<< "  actual:   " << (isActualLine ? actualLine : "<end>") << "\n";
+			break;
+		}
+		++lineNumber;
+	}
+	return false;
+}
+
+bool isNear(const float a, const float b)
+{
+	return std::abs(a - b) <= positionTolerance;
+}
+
+std::vector<Case> createCases(const Fonts& fonts)
+{
+	std::vector<Case> cases;
+
+	cases.push_back({ "basic", [&](SfmlTextAline& t)
+	{
+		t.setFont(fonts.sans);
+		t.setString("Hello, world!\nA second line: AVAST, Wave To You.");
+	} });
+
+	cases.push_back({ "alignments", [&](SfmlTextAline& t)
+	{
+		t.setFont(fonts.sans);
+		t.setCharacterSize(24u);
+		t.setMinWidth(420.f);
+		t.setAlignment(SfmlTextAline::Alignment::Center);
+		t.setLineAlignment(1u, SfmlTextAline::Alignment::Right);
+		t.setLineAlignment(2u, SfmlTextAline::Alignment::JustifyWhitespace);
+		t.setLineAlignment(3u, SfmlTextAline::Alignment::JustifyCharacters);
+		t.setString("centred line\nright aligned line\njustified through whitespace\njustified characters\nlast");
+	} });
+
+	cases.push_back({ "line overrides", [&](SfmlTextAline& t)
+	{
+		t.setFont(fonts.sans);
+		t.setCharacterSize(20u);
+		t.setColor(sf::Color(200u, 180u, 40u, 220u));
+		t.setLineOffset(0u, { 12.5f, -3.f });
+		t.setLineColor(1u, sf::Color(10u, 20u, 250u));
+		t.setLineBold(1u, true);
+		t.setLineItalic(2u, true);
+		t.setLineAlignment(3u, SfmlTextAline::Alignment::Right);
+		t.setLetterSpacingMultiplier(0.25f);
+		t.setLineHeightMultiplier(1.5f);
+		t.setString("offset line\nbold coloured line\nitalic line\nright aligned\n\nafter an empty line");
+	} });
+
+	cases.push_back({ "styles", [&](SfmlTextAline& t)
+	{
+		t.setFont(fonts.sans);
+		t.setCharacterSize(33u);
+		t.setTextStyle(sf::Text::Style::Bold | sf::Text::Style::Italic);
+		t.setItalicShear(0.35f);
+		t.setIsRoundingApplied(false);
+		t.setAlignment(SfmlTextAline::Alignment::Center);
+		t.setString("Bold italic\nwithout rounding");
+	} });
+
+	cases.push_back({ "tabs", [&](SfmlTextAline& t)
+	{
+		t.setFont(fonts.sans);
+		t.setTabLength(3u);
+		t.setString("name\tvalue\n\tindented\ttwice\t\n trailing space ");
+	} });
+
+	cases.push_back({ "unicode", [&](SfmlTextAline& t)
+	{
+		t.setFont(fonts.sans);
+		t.setCharacterSize(28u);
+		t.setString(toSfmlString(U"Ünïcödé – ß Ωα\nПривет"));
+	} });
+
+	cases.push_back({ "monospace", [&](SfmlTextAline& t)
+	{
+		t.setFont(fonts.mono);
+		t.setIsMonospace();
+		t.setTabLength(4u);
+		t.setLineBold(1u, true);
+		t.setLetterSpacingMultiplier(0.1f);
+		t.setString("int\tmain()\n{\treturn 0;\n\tx\t= 12;\n}");
+	} });
+
+	cases.push_back({ "table", [&](SfmlTextAline& t)
+	{
+		t.setFont(fonts.sans);
+		t.setCharacterSize(22u);
+		t.setIsTableLayout(true);
+		t.setTabLength(2u);
+		t.setColumnAlignment(0u, SfmlTextAline::Alignment::Right);
+		t.setColumnAlignment(1u, SfmlTextAline::Alignment::Center);
+		t.setColumnDecimalAlignment(2u);
+		t.setAlignment(SfmlTextAline::Alignment::Right);
+		t.setMinWidth(500.f);
+		t.setLineBold(0u, true);
+		t.setString("Item\tCode\tPrice\nApple\tA1\t1.5\nWatermelon\tW22\t12.25\nFig\t\t100\n\tZ\t.5 ");
+	} });
+
+	return cases;
+}
+
+// compares with (or, if updating, stores) the output in the tests folder
+int testGoldenFile(const std::string& relativePath, const std::string& actual, const bool isUpdate)
+{
+	const std::string filename{ getFilename(relativePath) };
+	if (isUpdate)
+	{
+		std::ofstream file(filename, std::ios::binary);
+		file << actual;
+		if (!file)
+		{
+			std::cerr << "FAILED: could not write " << filename << "\n";
+			return exitFailed;
+		}
+		std::cout << "golden output written to " << filename << "\n";
+		return exitPassed;
+	}
+
+	std::ifstream file(filename, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "SKIPPED: no golden output (" << filename << "); create it with --update-golden\n";
+		return exitSkipped;
+	}
+	std::ostringstream expected;
+	expected << file.rdbuf();
+
+	return compare(expected.str(), actual, relativePath) ? exitPassed : exitFailed;
+}
+
+int testStructure(const Fonts& fonts, const bool isUpdate)
+{
+	std::string actual;
+	for (auto& testCase : createCases(fonts))
+	{
+		SfmlTextAline sfmlTextAline;
+		testCase.setUp(sfmlTextAline);
+		actual += "case " + testCase.name + "\n" + describeStructure(sfmlTextAline);
+	}
+	return testGoldenFile("structure.golden", actual, isUpdate);
+}
+
+int testGolden(const Fonts& fonts, const bool isUpdate)
+{
+	std::string actual;
+	for (auto& testCase : createCases(fonts))
+		actual += "case " + testCase.name + "\n" + layOut(testCase.setUp, Mode::Immediate);
+	return testGoldenFile("layouts.golden", actual, isUpdate);
+}
+
+// quads match the positions sf::Text gives each character (regular style, no tabs: as sf::Text lays them out)
+int testText(const Fonts& fonts)
+{
+	const std::vector<sf::String> strings
+	{
+		"Hello, world!",
+		"AVAST Wave To You\nkerning: AV Ta Yo LT",
+		"Multiple\nlines of\n\ntext",
+		"  leading and trailing spaces  ",
+		toSfmlString(U"Ünïcödé ßäöü – Ω"),
+	};
+	const unsigned int characterSizes[]{ 12u, 30u, 57u };
+	const sf::Color color{ 10u, 200u, 30u, 240u };
+
+	bool isPassed{ true };
+	for (const unsigned int characterSize : characterSizes)
+	{
+		for (auto& string : strings)
+		{
+			sf::Text sfmlText(string, fonts.sans, characterSize);
+			sfmlText.setFillColor(color);
+			SfmlTextAline sfmlTextAline(sfmlText);
+			sfmlTextAline.setIsRoundingApplied(false);
+
+			const std::string description{ "\"" + escape(string) + "\" at size " + std::to_string(characterSize) };
+			const std::vector<sf::Vertex>& vertices{ sfmlTextAline.getVertices() };
+			std::size_t quad{ 0u };
+			std::uint32_t prevChar{ 0u };
+			for (std::size_t i{ 0u }; i < string.getSize(); ++i)
+			{
+				const std::uint32_t currentChar{ string[i] };
+				const float kerning{ fonts.sans.getKerning(prevChar, currentChar, characterSize) };
+				prevChar = currentChar;
+				if (isWhitespace(currentChar))
+					continue;
+				if (((quad + 1u) * 6u) > vertices.size())
+				{
+					std::cerr << "FAILED: " << description << ": too few quads\n";
+					isPassed = false;
+					break;
+				}
+
+				const sf::Glyph& glyph{ fonts.sans.getGlyph(currentChar, characterSize, false) };
+				const sf::Vector2f position{ sfmlText.findCharacterPos(i) };
+				const float left{ position.x + kerning + glyph.bounds.left };
+				const float top{ position.y + static_cast<float>(characterSize) + glyph.bounds.top };
+				const sf::Vertex* quadVertices{ vertices.data() + (quad * 6u) };
+
+				bool isQuadCorrect{ isNear(quadVertices[0u].position.x, left) && isNear(quadVertices[0u].position.y, top)
+					&& isNear(quadVertices[3u].position.x, left + glyph.bounds.width) && isNear(quadVertices[3u].position.y, top + glyph.bounds.height)
+					&& (quadVertices[0u].texCoords == sf::Vector2f(static_cast<float>(glyph.textureRect.left), static_cast<float>(glyph.textureRect.top)))
+					&& (quadVertices[3u].texCoords == sf::Vector2f(static_cast<float>(glyph.textureRect.left + glyph.textureRect.width), static_cast<float>(glyph.textureRect.top + glyph.textureRect.height))) };
+				for (std::size_t v{ 0u }; v < 6u; ++v)
+					isQuadCorrect = isQuadCorrect && (quadVertices[v].color == color);
+				if (!isQuadCorrect)
+				{
+					std::cerr << "FAILED: " << description << ": character " << i << " at (" << quadVertices[0u].position.x << ", " << quadVertices[0u].position.y
+						<< ") instead of (" << left << ", " << top << ")\n";
+					isPassed = false;
+					break;
+				}
+				++quad;
+			}
+			if ((quad * 6u) != vertices.size())
+			{
+				std::cerr << "FAILED: " << description << ": " << (vertices.size() / 6u) << " quads instead of " << quad << "\n";
+				isPassed = false;
+			}
+		}
+	}
+	return isPassed ? exitPassed : exitFailed;
+}
+
+int testModes(const Fonts& fonts)
+{
+	const std::size_t layoutCharacterBudgets[]{ 1u, 7u, 1000u };
+
+	bool isPassed{ true };
+	for (auto& testCase : createCases(fonts))
+	{
+		const std::string expected{ layOut(testCase.setUp, Mode::Immediate) };
+		for (const std::size_t layoutCharacterBudget : layoutCharacterBudgets)
+			isPassed = compare(expected, layOut(testCase.setUp, Mode::Progressive, layoutCharacterBudget), testCase.name + " (progressive, budget " + std::to_string(layoutCharacterBudget) + ")") && isPassed;
+		isPassed = compare(expected, layOut(testCase.setUp, Mode::Async), testCase.name + " (async)") && isPassed;
+		isPassed = compare(expected, layOut(testCase.setUp, Mode::AsyncAfterProgressive), testCase.name + " (async after progressive)") && isPassed;
+		isPassed = compare(expected, layOut(testCase.setUp, Mode::Shared), testCase.name + " (shared)") && isPassed;
+	}
+	return isPassed ? exitPassed : exitFailed;
+}
+
+class Fuzzer
+{
+public:
+	Fuzzer(const Fonts& fonts, const unsigned int seed)
+		: m_fonts(fonts)
+		, m_random(seed)
+	{
+	}
+
+	// random string and settings (including per-line overrides); any mode must give the same layout
+	bool testModes(const std::string& description)
+	{
+		const bool isMonospace{ getChance(4u) };
+		const bool isTableLayout{ !isMonospace && getChance(4u) };
+		const sf::String string{ isTableLayout ? getTableString() : getString(getNumber(0u, 90u)) };
+		const std::size_t characterSize{ getNumber(8u, 48u) };
+		const sf::Color color{ getColor() };
+		const std::size_t tabLength{ getNumber(1u, 6u) };
+		const SfmlTextAline::Alignment alignment{ getAlignment() };
+		const float minWidth{ getChance(2u) ? 0.f : static_cast<float>(getNumber(0u, 600u)) };
+		const sf::Uint32 textStyle{ static_cast<sf::Uint32>(getNumber(0u, 3u)) };
+		const float lineHeightMultiplier{ getChoice({ 1.f, 0.8f, 1.5f }) };
+		const float letterSpacingMultiplier{ getChoice({ 0.f, 0.25f, -0.1f }) };
+		const bool isRoundingApplied{ getChance(2u) };
+		std::vector<std::pair<std::size_t, SfmlTextAline::Alignment>> columnAlignments;
+		std::vector<std::pair<std::size_t, std::uint32_t>> columnDecimalPoints;
+		if (isTableLayout)
+		{
+			for (std::size_t c{ 0u }; c < 4u; ++c)
+			{
+				if (getChance(4u))
+					columnDecimalPoints.push_back({ c, getChoice({ '.', ',' }) });
+				else
+					columnAlignments.push_back({ c, getAlignment() });
+			}
+		}
+		std::vector<std::pair<std::size_t, SfmlTextAline::Alignment>> lineAlignments;
+		std::vector<std::pair<std::size_t, sf::Vector2f>> lineOffsets;
+		std::vector<std::pair<std::size_t, sf::Color>> lineColors;
+		std::vector<std::pair<std::size_t, bool>> lineBolds;
+		std::vector<std::pair<std::size_t, bool>> lineItalics;
+		for (std::size_t l{ 0u }; l < 6u; ++l)
+		{
+			if (getChance(4u))
+				lineAlignments.push_back({ l, getAlignment() });
+			if (getChance(5u))
+				lineOffsets.push_back({ l, { static_cast<float>(getNumber(0u, 40u)) - 20.f, static_cast<float>(getNumber(0u, 10u)) * 0.5f } });
+			if (getChance(5u))
+				lineColors.push_back({ l, getColor() });
+			if (getChance(4u))
+				lineBolds.push_back({ l, getChance(2u) });
+			if (getChance(5u))
+				lineItalics.push_back({ l, getChance(2u) });
+		}
+
+		const SetUp setUp{ [=, &fonts = m_fonts](SfmlTextAline& t)
+		{
+			t.setFont(isMonospace ? fonts.mono : fonts.sans);
+			t.setString(string);
+			t.setCharacterSize(characterSize);
+			t.setColor(color);
+			t.setTabLength(tabLength);
+			t.setAlignment(alignment);
+			t.setMinWidth(minWidth);
+			t.setTextStyle(textStyle);
+			t.setLineHeightMultiplier(lineHeightMultiplier);
+			t.setLetterSpacingMultiplier(letterSpacingMultiplier);
+			t.setIsRoundingApplied(isRoundingApplied);
+			t.setIsMonospace(isMonospace);
+			t.setIsTableLayout(isTableLayout);
+			for (auto& columnAlignment : columnAlignments)
+				t.setColumnAlignment(columnAlignment.first, columnAlignment.second);
+			for (auto& columnDecimalPoint : columnDecimalPoints)
+				t.setColumnDecimalAlignment(columnDecimalPoint.first, columnDecimalPoint.second);
+			for (auto& lineAlignment : lineAlignments)
+				t.setLineAlignment(lineAlignment.first, lineAlignment.second);
+			for (auto& lineOffset : lineOffsets)
+				t.setLineOffset(lineOffset.first, lineOffset.second);
+			for (auto& lineColor : lineColors)
+				t.setLineColor(lineColor.first, lineColor.second);
+			for (auto& lineBold : lineBolds)
+				t.setLineBold(lineBold.first, lineBold.second);
+			for (auto& lineItalic : lineItalics)
+				t.setLineItalic(lineItalic.first, lineItalic.second);
+		} };
+
+		const std::string fullDescription{ description + " \"" + escape(string) + "\"" + (isMonospace ? " monospace" : "") + (isTableLayout ? " table" : "") };
+		const std::string expected{ layOut(setUp, Mode::Immediate) };
+
+		std::size_t numberOfQuads{ 0u };
+		for (const sf::Uint32 character : string)
+			numberOfQuads += isWhitespace(character) ? 0u : 1u;
+		if (expected.find("vertices " + std::to_string(numberOfQuads * 6u) + "\n") == std::string::npos)
+		{
+			std::cerr << "FAILED: " << fullDescription << ": expected " << numberOfQuads << " quads\n";
+			return false;
+		}
+
+		bool isPassed{ compare(expected, layOut(setUp, Mode::Progressive, getNumber(1u, 12u)), fullDescription + " (progressive)") };
+		isPassed = compare(expected, layOut(setUp, Mode::Async), fullDescription + " (async)") && isPassed;
+		isPassed = compare(expected, layOut(setUp, Mode::Shared), fullDescription + " (shared)") && isPassed;
+		return isPassed;
+	}
+
+	// each character is placed at its column (columns of space width; tabs move to the next tab stop)
+	bool testMonospaceColumns(const std::string& description)
+	{
+		const sf::String string{ getString(getNumber(1u, 90u)) };
+		const unsigned int characterSize{ static_cast<unsigned int>(getNumber(8u, 48u)) };
+		const std::size_t tabLength{ getNumber(1u, 6u) };
+		const float letterSpacingMultiplier{ getChoice({ 0.f, 0.25f, -0.1f }) };
+		const bool isBold{ getChance(2u) };
+
+		SfmlTextAline sfmlTextAline;
+		sfmlTextAline.setFont(m_fonts.mono);
+		sfmlTextAline.setIsMonospace(true);
+		sfmlTextAline.setString(string);
+		sfmlTextAline.setCharacterSize(characterSize);
+		sfmlTextAline.setTabLength(tabLength);
+		sfmlTextAline.setLetterSpacingMultiplier(letterSpacingMultiplier);
+		if (isBold)
+			sfmlTextAline.setTextStyle(sf::Text::Style::Bold);
+		const std::vector<sf::Vertex>& vertices{ sfmlTextAline.getVertices() };
+
+		const float spaceWidth{ m_fonts.mono.getGlyph(' ', characterSize, isBold).advance };
+		const float columnWidth{ spaceWidth + (spaceWidth * letterSpacingMultiplier) };
+		std::size_t column{ 0u };
+		std::size_t quad{ 0u };
+		for (std::size_t i{ 0u }; i < string.getSize(); ++i)
+		{
+			switch (string[i])
+			{
+			case ' ':
+				++column;
+				continue;
+			case '\t':
+				column = ((column / tabLength) + 1u) * tabLength;
+				continue;
+			case '\n':
+				column = 0u;
+				continue;
+			default:
+				break;
+			}
+
+			const float expected{ static_cast<float>(column) * columnWidth + m_fonts.mono.getGlyph(string[i], characterSize, isBold).bounds.left };
+			if ((((quad + 1u) * 6u) > vertices.size()) || !isNear(vertices[quad * 6u].position.x, expected))
+			{
+				std::cerr << "FAILED: " << description << " monospace \"" << escape(string) << "\": character " << i << " is not at column " << column << "\n";
+				return false;
+			}
+			++column;
+			++quad;
+		}
+		return true;
+	}
+
+	// cells in the same column start at the same position on every line (whatever the global alignment)
+	bool testTableColumns(const std::string& description)
+	{
+		const std::size_t numberOfColumns{ getNumber(1u, 4u) };
+		const std::size_t numberOfRows{ getNumber(1u, 5u) };
+		sf::String string;
+		for (std::size_t r{ 0u }; r < numberOfRows; ++r)
+		{
+			if (r > 0u)
+				string += "\n";
+			for (std::size_t c{ 0u }; c < numberOfColumns; ++c)
+			{
+				if (c > 0u)
+					string += "\t";
+				string += getWord(getNumber(1u, 8u));
+			}
+		}
+		const unsigned int characterSize{ static_cast<unsigned int>(getNumber(8u, 48u)) };
+		const SfmlTextAline::Alignment alignment{ getAlignment() };
+		const float minWidth{ getChance(2u) ? 0.f : static_cast<float>(getNumber(0u, 600u)) };
+		const bool isRoundingApplied{ getChance(2u) };
+
+		SfmlTextAline sfmlTextAline;
+		sfmlTextAline.setFont(m_fonts.sans);
+		sfmlTextAline.setIsTableLayout(true);
+		sfmlTextAline.setString(string);
+		sfmlTextAline.setCharacterSize(characterSize);
+		sfmlTextAline.setAlignment(alignment);
+		sfmlTextAline.setMinWidth(minWidth);
+		sfmlTextAline.setIsRoundingApplied(isRoundingApplied);
+		const std::vector<sf::Vertex>& vertices{ sfmlTextAline.getVertices() };
+
+		// start of each cell's first glyph (without its kerning and bearing)
+		std::vector<float> columnStarts(numberOfColumns);
+		std::size_t row{ 0u };
+		std::size_t column{ 0u };
+		std::size_t quad{ 0u };
+		std::uint32_t prevChar{ 0u };
+		bool isCellStart{ true };
+		for (std::size_t i{ 0u }; i < string.getSize(); ++i)
+		{
+			const std::uint32_t currentChar{ string[i] };
+			if (isWhitespace(currentChar))
+			{
+				if (currentChar == '\n')
+				{
+					++row;
+					column = 0u;
+				}
+				else
+					++column;
+				isCellStart = true;
+				prevChar = currentChar;
+				continue;
+			}
+
+			if (isCellStart)
+			{
+				const float kerning{ m_fonts.sans.getKerning(prevChar, currentChar, characterSize) };
+				const float start{ vertices[quad * 6u].position.x - kerning - m_fonts.sans.getGlyph(currentChar, characterSize, false).bounds.left };
+				if (row == 0u)
+					columnStarts[column] = start;
+				else if (!isNear(start, columnStarts[column]))
+				{
+					std::cerr << "FAILED: " << description << " table \"" << escape(string) << "\" (alignment " << static_cast<int>(alignment) << "): column " << column << " starts at "
+						<< start << " on line " << row << " instead of " << columnStarts[column] << "\n";
+					return false;
+				}
+				isCellStart = false;
+			}
+			prevChar = currentChar;
+			++quad;
+		}
+		return true;
+	}
+
+private:
+	const Fonts& m_fonts;
+	std::mt19937 m_random;
+
+	std::size_t getNumber(const std::size_t minimum, const std::size_t maximum)
+	{
+		return std::uniform_int_distribution<std::size_t>(minimum, maximum)(m_random);
+	}
+
+	bool getChance(const std::size_t oneIn)
+	{
+		return getNumber(1u, oneIn) == 1u;
+	}
+
+	template <class T>
+	T getChoice(const std::initializer_list<T> choices)
+	{
+		return *(choices.begin() + getNumber(0u, choices.size() - 1u));
+	}
+
+	SfmlTextAline::Alignment getAlignment()
+	{
+		return static_cast<SfmlTextAline::Alignment>(getNumber(0u, 4u));
+	}
+
+	sf::Color getColor()
+	{
+		return sf::Color(static_cast<sf::Uint8>(getNumber(0u, 255u)), static_cast<sf::Uint8>(getNumber(0u, 255u)), static_cast<sf::Uint8>(getNumber(0u, 255u)), static_cast<sf::Uint8>(getNumber(0u, 255u)));
+	}
+
+	sf::String getString(const std::size_t length)
+	{
+		static const std::u32string characters{ U"abcdefghijklmnopqrstuvwxyzAVTWY0123456789.,;:'!?-   \t\néßÜΩ–" };
+		std::u32string string;
+		for (std::size_t i{ 0u }; i < length; ++i)
+			string += characters[getNumber(0u, characters.size() - 1u)];
+		return toSfmlString(string);
+	}
+
+	sf::String getWord(const std::size_t length)
+	{
+		static const std::u32string characters{ U"abcdefghijklmnopqrstuvwxyzAVTWY0123456789.,-éß" };
+		std::u32string word;
+		for (std::size_t i{ 0u }; i < length; ++i)
+			word += characters[getNumber(0u, characters.size() - 1u)];
+		return toSfmlString(word);
+	}
+
+	// rows of cells (some empty or padded with spaces)
+	sf::String getTableString()
+	{
+		sf::String string;
+		const std::size_t numberOfRows{ getNumber(1u, 6u) };
+		for (std::size_t r{ 0u }; r < numberOfRows; ++r)
+		{
+			if (r > 0u)
+				string += "\n";
+			const std::size_t numberOfColumns{ getNumber(1u, 4u) };
+			for (std::size_t c{ 0u }; c < numberOfColumns; ++c)
+			{
+				if (c > 0u)
+					string += "\t";
+				if (getChance(6u))
+					continue;
+				if (getChance(6u))
+					string += " ";
+				string += getWord(getNumber(1u, 8u));
+				if (getChance(6u))
+					string += " ";
+			}
+		}
+		return string;
+	}
+};
+
+int testFuzz(const Fonts& fonts)
+{
+	Fuzzer fuzzer(fonts, fuzzSeed);
+	bool isPassed{ true };
+	for (std::size_t i{ 0u }; i < fuzzIterations; ++i)
+	{
+		const std::string description{ "seed " + std::to_string(fuzzSeed) + ", iteration " + std::to_string(i) + ":" };
+		isPassed = fuzzer.testModes(description) && isPassed;
+		isPassed = fuzzer.testMonospaceColumns(description) && isPassed;
+		isPassed = fuzzer.testTableColumns(description) && isPassed;
+	}
+	return isPassed ? exitPassed : exitFailed;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	const std::string test{ (argc > 1) ? argv[1] : "" };
+	const bool isGoldenUpdate{ (argc > 2) && (std::string(argv[2]) == "--update-golden") };
+
+	Fonts fonts;
+	if (!loadFonts(fonts))
+	{
+		std::cerr << "FAILED: could not load fonts from " << getFilename("fonts") << "\n";
+		return exitFailed;
+	}
+
+	if (test == "structure")
+		return testStructure(fonts, isGoldenUpdate);
+	if (test == "golden")
+		return testGolden(fonts, isGoldenUpdate);
+	if (test == "text")
+		return testText(fonts);
+	if (test == "modes")
+		return testModes(fonts);
+	if (test == "fuzz")
+		return testFuzz(fonts);
+
+	std::cerr << "usage: SfmlTextAlineTests <structure|golden|text|modes|fuzz> [--update-golden]\n";
+	return exitFailed;
+}